@@ -0,0 +1,32 @@
+#include "allocation_counter.h"
+#include <cstdlib>
+#include <new>
+
+#ifndef NDEBUG
+
+namespace {
+// A plain integer: each thread only ever touches its own
+thread_local std::size_t allocation_count = 0;
+}
+
+// Replacement global allocation functions. The array and nothrow forms call
+// these, so every allocation is counted exactly once.
+void *operator new(std::size_t size) {
+  allocation_count++;
+  if (void *memory = std::malloc(size == 0 ? 1 : size)) return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
+std::size_t AllocationCounter::Count() {
+  return allocation_count;
+}
+
+#else
+
+std::size_t AllocationCounter::Count() { return 0; }
+
+#endif
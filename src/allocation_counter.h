@@ -0,0 +1,17 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+// Counts heap allocations made through the global operator new, separately
+// for each thread, so a check around one call on one thread is not thrown
+// off by allocations on others. The counting operator new is only compiled
+// into debug builds (NDEBUG not defined); in release builds Count always
+// returns 0.
+class AllocationCounter {
+ public:
+  // Returns the number of allocations the calling thread has made since it started
+  static std::size_t Count();
+};
+
+#endif
@@ -0,0 +1,160 @@
+#include "autopilot.h"
+#include <algorithm>
+#include <cstdlib>
+
+// Constructor
+// Sizes every buffer for a search that reaches the whole board
+Autopilot::Autopilot(int grid_width, int grid_height)
+  : grid_width(grid_width),
+    grid_height(grid_height),
+    visited(static_cast<std::size_t>(grid_width) * grid_height),
+    came_from(static_cast<std::size_t>(grid_width) * grid_height) {
+  for (std::vector<int> &bucket : buckets) {
+    bucket.reserve(static_cast<std::size_t>(grid_width) * grid_height);
+  }
+  path.reserve(static_cast<std::size_t>(grid_width) * grid_height);
+}
+
+Snake::Direction Autopilot::NextDirection(Snake const &snake, SDL_Point const &food) {
+  SDL_Point head_cell = snake.GetHeadCell();
+  int head = head_cell.y * grid_width + head_cell.x;
+  if (food.x < 0) return FallbackDirection(snake);
+  int goal = food.y * grid_width + food.x;
+  if (goal == failed_goal && StillUnreachable(snake, head)) return FallbackDirection(snake);
+  failed_goal = -1;
+
+  // Advance along the cached path once the head has entered its next cell
+  if (goal == path_goal && !path.empty() && head == path.back()) {
+    path_from = head;
+    path.pop_back();
+  }
+  bool on_path = goal == path_goal && !path.empty() && head == path_from;
+  if (!on_path || snake.GetOccupancy().IsOccupied(path.back())) {
+    if (!Search(snake.GetOccupancy(), head, goal)) {
+      path_goal = -1;
+      failed_goal = goal;
+      failed_tail = TailCell(snake);
+      failed_size = snake.GetSize();
+      return FallbackDirection(snake);
+    }
+  }
+  return DirectionTo(head, path.back());
+}
+
+bool Autopilot::Search(OccupancyGrid const &occupancy, int start, int goal) {
+  search_count++;
+  path.clear();
+  path_goal = -1;
+  if (start == goal) return false;
+  if (++generation == 0) {
+    // The stamps wrapped around; forget every old mark once
+    std::fill(visited.begin(), visited.end(), 0);
+    generation = 1;
+  }
+  for (std::vector<int> &bucket : buckets) bucket.clear();
+
+  int f = Distance(start, goal);
+  visited[start] = generation;
+  buckets[f % 3].push_back(start);
+  int open = 1;
+  while (open > 0) {
+    std::vector<int> &current = buckets[f % 3];
+    if (current.empty()) {
+      f++;
+      continue;
+    }
+    // Last in, first out within a bucket, so the search dives towards the goal
+    int cell = current.back();
+    current.pop_back();
+    open--;
+    int h = Distance(cell, goal);
+    int g = f - h;
+    for (int d = 0; d < 4; ++d) {
+      int next = Step(cell, d);
+      if (visited[next] == generation) continue;
+      if (next != goal && occupancy.IsOccupied(next)) continue;
+      visited[next] = generation;
+      came_from[next] = static_cast<std::uint8_t>(d);
+      if (next == goal) {
+        // Walk back to the start; the goal ends up at the front
+        for (int c = goal; c != start; c = Step(c, came_from[c] ^ 1)) {
+          path.push_back(c);
+        }
+        path_goal = goal;
+        path_from = start;
+        return true;
+      }
+      buckets[(g + 1 + Distance(next, goal)) % 3].push_back(next);
+      open++;
+    }
+  }
+  return false;
+}
+
+int Autopilot::Distance(int cell, int goal) const {
+  int dx = std::abs(cell % grid_width - goal % grid_width);
+  int dy = std::abs(cell / grid_width - goal / grid_width);
+  return std::min(dx, grid_width - dx) + std::min(dy, grid_height - dy);
+}
+
+int Autopilot::Step(int cell, int d) const {
+  int x = cell % grid_width + Snake::kDirectionDx[d];
+  int y = cell / grid_width + Snake::kDirectionDy[d];
+  x = x < 0 ? x + grid_width : (x >= grid_width ? x - grid_width : x);
+  y = y < 0 ? y + grid_height : (y >= grid_height ? y - grid_height : y);
+  return y * grid_width + x;
+}
+
+Snake::Direction Autopilot::DirectionTo(int cell, int next) const {
+  for (int d = 0; d < 4; ++d) {
+    if (Step(cell, d) == next) return static_cast<Snake::Direction>(d);
+  }
+  return Snake::Direction::kUp;
+}
+
+// The marked region holds every cell the head can reach, and possibly cells
+// the snake has covered since. Between two calls the snake moves at most one
+// cell, so at most the old tail cell is freed. If that cell touches the region
+// and a free cell outside it, or the food, the two may now connect; if it
+// touches only the region, it becomes part of it.
+bool Autopilot::StillUnreachable(Snake const &snake, int head) {
+  if (visited[head] != generation || snake.GetSize() < failed_size) return false;
+  int tail = TailCell(snake);
+  failed_size = snake.GetSize();
+  if (tail == failed_tail) return true;
+  int freed = failed_tail;
+  failed_tail = tail;
+  if (snake.GetOccupancy().IsOccupied(freed)) return true;
+
+  bool joins_region = false;
+  bool joins_outside = false;
+  bool moved_one_cell = false;
+  for (int d = 0; d < 4; ++d) {
+    int next = Step(freed, d);
+    if (next == tail) moved_one_cell = true;
+    if (visited[next] == generation) {
+      joins_region = true;
+    } else if (next == failed_goal || !snake.GetOccupancy().IsOccupied(next)) {
+      joins_outside = true;
+    }
+  }
+  if (!moved_one_cell || (joins_region && joins_outside)) return false;
+  if (joins_region) visited[freed] = generation;
+  return true;
+}
+
+int Autopilot::TailCell(Snake const &snake) const {
+  SDL_Point cell = snake.GetBody().Size() > 0 ? snake.GetBody().Front() : snake.GetHeadCell();
+  return cell.y * grid_width + cell.x;
+}
+
+Snake::Direction Autopilot::FallbackDirection(Snake const &snake) const {
+  SDL_Point head_cell = snake.GetHeadCell();
+  int head = head_cell.y * grid_width + head_cell.x;
+  int straight = static_cast<int>(snake.GetDirection());
+  if (!snake.GetOccupancy().IsOccupied(Step(head, straight))) return snake.GetDirection();
+  for (int d = 0; d < 4; ++d) {
+    if (!snake.GetOccupancy().IsOccupied(Step(head, d))) return static_cast<Snake::Direction>(d);
+  }
+  return snake.GetDirection();
+}
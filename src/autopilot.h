@@ -0,0 +1,77 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include <cstdint>
+#include <vector>
+#include "SDL.h"
+#include "snake.h"
+
+// Steers a snake to the food without a player, for soak tests and demos.
+//
+// The path is planned with A* over the wrapping grid, using the wrapped
+// Manhattan distance as heuristic and a bucket queue of f values, and
+// treats every cell the snake covers as a wall. Cells are closed when first
+// reached, which keeps the search linear in the cells it touches; on open
+// boards it follows an almost straight line to the food, at the cost of not
+// always finding the very shortest path around obstacles.
+//
+// All search buffers are allocated once. Visited marks carry a search
+// generation, so nothing is cleared between searches. The planned path is
+// kept and followed until the food moves or the head leaves it, so most
+// calls do no search at all.
+//
+// A search that cannot reach the food leaves the region it flooded marked.
+// Until the food moves, the board only opens up where the tail frees a cell,
+// so the next search waits until a freed cell joins that region to a cell
+// outside it, instead of flooding the region again on every call. This
+// relies on being called once per tick, as Game::Update does.
+class Autopilot {
+ public:
+  // Constructor
+  Autopilot(int grid_width, int grid_height);
+
+  // Direction the snake should move in now. If no path to the food exists,
+  // picks a free neighbouring cell, preferring to keep going straight.
+  Snake::Direction NextDirection(Snake const &snake, SDL_Point const &food);
+
+  // Number of searches run so far
+  std::size_t GetSearchCount() const { return search_count; }
+
+ private:
+  // Plans a path from start to goal into path; returns false if there is none
+  bool Search(OccupancyGrid const &occupancy, int start, int goal);
+  // Wrapped Manhattan distance between two cells
+  int Distance(int cell, int goal) const;
+  // Cell one step from cell in direction d, wrapping around the board
+  int Step(int cell, int d) const;
+  // Direction from cell to its neighbour next
+  Snake::Direction DirectionTo(int cell, int next) const;
+  // Direction used when the food cannot be reached
+  Snake::Direction FallbackDirection(Snake const &snake) const;
+  // True if the food the last search failed to reach is still out of reach
+  // from head; grows the marked region by the cell the tail freed, if any
+  bool StillUnreachable(Snake const &snake, int head);
+  // Cell of the tail end, the head's for a snake without a body
+  int TailCell(Snake const &snake) const;
+
+  int grid_width;
+  int grid_height;
+  std::size_t search_count{0};
+
+  std::uint32_t generation{0}; // Stamp of the current search
+  std::vector<std::uint32_t> visited; // Generation that last reached each cell
+  std::vector<std::uint8_t> came_from; // Direction that first reached each cell
+  // Open cells by f value modulo 3; a step raises f by at most 2
+  std::vector<int> buckets[3];
+
+  std::vector<int> path; // Planned cells, the next one at the back
+  int path_goal{-1}; // Food cell the path leads to
+  int path_from{-1}; // Cell the head is in while following path.back()
+
+  // Set when the last search failed; its generation marks the region flooded
+  int failed_goal{-1}; // Food cell that could not be reached, -1 if none
+  int failed_tail{-1}; // Tail cell when the region was last brought up to date
+  int failed_size{0}; // Snake size then; a smaller one means the snake restarted
+};
+
+#endif
@@ -0,0 +1,273 @@
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include "snake.h"
+
+namespace {
+
+// Presets as the settings they change from the defaults
+struct Preset {
+  char const *name;
+  std::vector<std::pair<char const *, char const *>> settings;
+};
+
+std::vector<Preset> const &Presets() {
+  static std::vector<Preset> const kPresets = {
+      {"tiny", {{"grid", "16"}, {"screen_width", "320"}, {"screen_height", "320"}}},
+      {"default", {}},
+      {"huge-board", {{"grid", "4096"}, {"screen_width", "1024"}, {"screen_height", "1024"},
+                      {"render_mode", "texture"}}},
+      {"benchmark", {{"grid", "128"}, {"frames_per_second", "240"}, {"autopilot", "true"}, {"overlay", "true"},
+                     {"render_mode", "texture"}}},
+  };
+  return kPresets;
+}
+
+std::string Trim(std::string const &text) {
+  std::size_t first = text.find_first_not_of(" \t\r");
+  if (first == std::string::npos) return "";
+  std::size_t last = text.find_last_not_of(" \t\r");
+  return text.substr(first, last - first + 1);
+}
+
+std::invalid_argument BadValue(std::string const &key, std::string const &value) {
+  return std::invalid_argument("Invalid value for " + key + ": '" + value + "'");
+}
+
+// Whole-string conversions; a trailing character or a sign where none is
+// allowed makes the value invalid
+unsigned long long ParseUnsigned(std::string const &key, std::string const &value) {
+  std::size_t used = 0;
+  unsigned long long result = 0;
+  try {
+    result = std::stoull(value, &used);
+  } catch (std::exception const &) {
+    throw BadValue(key, value);
+  }
+  if (used != value.size() || value[0] == '-') throw BadValue(key, value);
+  return result;
+}
+
+double ParseDouble(std::string const &key, std::string const &value) {
+  std::size_t used = 0;
+  double result = 0;
+  try {
+    result = std::stod(value, &used);
+  } catch (std::exception const &) {
+    throw BadValue(key, value);
+  }
+  if (used != value.size()) throw BadValue(key, value);
+  return result;
+}
+
+bool IsTrue(std::string const &value) {
+  return value == "true" || value == "1" || value == "on" || value == "yes";
+}
+
+bool IsFalse(std::string const &value) {
+  return value == "false" || value == "0" || value == "off" || value == "no";
+}
+
+bool ParseBool(std::string const &key, std::string const &value) {
+  if (IsTrue(value)) return true;
+  if (IsFalse(value)) return false;
+  throw BadValue(key, value);
+}
+
+// Sizes from 1 up to max; the snake's fixed-point position limits grids to 16383 cells a side
+std::size_t ParseSize(std::string const &key, std::string const &value, unsigned long long max) {
+  unsigned long long size = ParseUnsigned(key, value);
+  if (size == 0 || size > max) throw BadValue(key, value);
+  return static_cast<std::size_t>(size);
+}
+
+constexpr unsigned long long kMaxGrid = 16383;
+constexpr unsigned long long kMaxScreen = 16384;
+// Frame rates outside this range leave FramePacer a period too long to wait or too short to keep
+constexpr double kMinFramesPerSecond = 1;
+constexpr double kMaxFramesPerSecond = 1000;
+
+bool IsBoolKey(std::string const &key) {
+  return key == "pipelined" || key == "autopilot" || key == "overlay";
+}
+
+}  // namespace
+
+std::vector<std::string> Config::PresetNames() {
+  std::vector<std::string> names;
+  for (Preset const &preset : Presets()) names.push_back(preset.name);
+  return names;
+}
+
+void Config::ApplyPreset(std::string const &name) {
+  auto preset = std::find_if(Presets().begin(), Presets().end(),
+                             [&name](Preset const &p) { return name == p.name; });
+  if (preset == Presets().end()) {
+    throw std::invalid_argument("Unknown preset: '" + name + "'");
+  }
+  *this = Config{};
+  for (auto const &setting : preset->settings) {
+    Set(setting.first, setting.second);
+  }
+}
+
+void Config::Set(std::string const &key, std::string const &value) {
+  if (key == "grid") {
+    grid_width = grid_height = ParseSize(key, value, kMaxGrid);
+  } else if (key == "grid_width") {
+    grid_width = ParseSize(key, value, kMaxGrid);
+  } else if (key == "grid_height") {
+    grid_height = ParseSize(key, value, kMaxGrid);
+  } else if (key == "screen_width") {
+    screen_width = ParseSize(key, value, kMaxScreen);
+  } else if (key == "screen_height") {
+    screen_height = ParseSize(key, value, kMaxScreen);
+  } else if (key == "frames_per_second") {
+    frames_per_second = ParseDouble(key, value);
+    if (!std::isfinite(frames_per_second) || frames_per_second < kMinFramesPerSecond ||
+        frames_per_second > kMaxFramesPerSecond) {
+      throw BadValue(key, value);
+    }
+  } else if (key == "ticks_per_second") {
+    ticks_per_second = ParseSize(key, value, 1000000);
+  } else if (key == "initial_speed") {
+    // At least one fixed-point step per tick; the grid bound is checked by Validate
+    initial_speed = static_cast<float>(ParseDouble(key, value));
+    if (!(initial_speed > 0 && initial_speed < kMaxGrid) || Snake::ToFixed(initial_speed) == 0) {
+      throw BadValue(key, value);
+    }
+  } else if (key == "speed_step") {
+    speed_step = static_cast<float>(ParseDouble(key, value));
+    if (!(speed_step >= 0 && speed_step < kMaxGrid)) throw BadValue(key, value);
+  } else if (key == "high_score_file") {
+    if (value.empty()) throw BadValue(key, value);
+    high_score_file = value;
+  } else if (key == "render_mode") {
+    if (value != "full" && value != "incremental" && value != "texture") throw BadValue(key, value);
+    render_mode = value;
+  } else if (key == "pipelined") {
+    pipelined = ParseBool(key, value);
+  } else if (key == "autopilot") {
+    autopilot = ParseBool(key, value);
+  } else if (key == "overlay") {
+    overlay = ParseBool(key, value);
+  } else if (key == "seed") {
+    if (value.empty()) {
+      seed.reset();
+    } else {
+      unsigned long long number = ParseUnsigned(key, value);
+      if (number > UINT32_MAX) throw BadValue(key, value);
+      seed = static_cast<std::uint32_t>(number);
+    }
+  } else if (key == "profile_file") {
+    profile_file = value;
+  } else if (key == "trace_file") {
+    trace_file = value;
+  } else if (key == "record_file") {
+    record_file = value;
+  } else if (key == "replay_file") {
+    replay_file = value;
+  } else {
+    throw std::invalid_argument("Unknown setting: '" + key + "'");
+  }
+}
+
+void Config::Load(std::string const &file_name) {
+  std::ifstream file(file_name);
+  if (!file) {
+    throw std::runtime_error("Could not read config file " + file_name);
+  }
+  std::string line;
+  int line_number = 0;
+  while (std::getline(file, line)) {
+    line_number++;
+    line = Trim(line.substr(0, line.find('#')));
+    if (line.empty()) continue;
+    std::size_t equals = line.find('=');
+    if (equals == std::string::npos) {
+      throw std::invalid_argument(file_name + ":" + std::to_string(line_number) + ": expected key = value");
+    }
+    std::string key = Trim(line.substr(0, equals));
+    std::string value = Trim(line.substr(equals + 1));
+    try {
+      if (key == "preset") {
+        ApplyPreset(value);
+      } else {
+        Set(key, value);
+      }
+    } catch (std::invalid_argument const &error) {
+      throw std::invalid_argument(file_name + ":" + std::to_string(line_number) + ": " + error.what());
+    }
+  }
+}
+
+void Config::ParseArgs(std::vector<std::string> const &args) {
+  for (std::size_t i = 0; i < args.size(); ++i) {
+    std::string const &arg = args[i];
+    if (arg.compare(0, 2, "--") != 0) {
+      throw std::invalid_argument("Unexpected argument: '" + arg + "'");
+    }
+    std::string key = arg.substr(2);
+    std::replace(key.begin(), key.end(), '-', '_');
+
+    // Flags that take no value
+    if (key == "incremental" || key == "texture") {
+      render_mode = key;
+      continue;
+    }
+    // Boolean flags take a value only if the next argument is one, so
+    // "--autopilot false" and a bare "--autopilot" both work
+    if (IsBoolKey(key)) {
+      bool has_value = i + 1 < args.size() && (IsTrue(args[i + 1]) || IsFalse(args[i + 1]));
+      Set(key, has_value ? args[++i] : "true");
+      continue;
+    }
+
+    if (i + 1 >= args.size()) {
+      throw std::invalid_argument("Missing value for " + arg);
+    }
+    std::string const &value = args[++i];
+    if (key == "preset") {
+      ApplyPreset(value);
+    } else if (key == "config") {
+      Load(value);
+    } else if (key == "profile" || key == "trace" || key == "record" || key == "replay") {
+      Set(key + "_file", value);
+    } else {
+      Set(key, value);
+    }
+  }
+  Validate();
+}
+
+void Config::Validate() const {
+  std::size_t grid = std::min(grid_width, grid_height);
+  if (initial_speed >= grid) {
+    throw std::invalid_argument("initial_speed must be less than the grid size (" + std::to_string(grid) + ")");
+  }
+}
+
+void Config::Write(std::ostream &out, char const *prefix) const {
+  out << prefix << "screen_width = " << screen_width << "\n";
+  out << prefix << "screen_height = " << screen_height << "\n";
+  out << prefix << "grid_width = " << grid_width << "\n";
+  out << prefix << "grid_height = " << grid_height << "\n";
+  out << prefix << "frames_per_second = " << frames_per_second << "\n";
+  out << prefix << "ticks_per_second = " << ticks_per_second << "\n";
+  out << prefix << "initial_speed = " << initial_speed << "\n";
+  out << prefix << "speed_step = " << speed_step << "\n";
+  out << prefix << "high_score_file = " << high_score_file << "\n";
+  out << prefix << "render_mode = " << render_mode << "\n";
+  out << prefix << "pipelined = " << (pipelined ? "true" : "false") << "\n";
+  out << prefix << "autopilot = " << (autopilot ? "true" : "false") << "\n";
+  out << prefix << "overlay = " << (overlay ? "true" : "false") << "\n";
+  out << prefix << "seed = ";
+  if (seed) out << *seed;
+  out << "\n";
+  out << prefix << "profile_file = " << profile_file << "\n";
+  out << prefix << "trace_file = " << trace_file << "\n";
+  out << prefix << "record_file = " << record_file << "\n";
+  out << prefix << "replay_file = " << replay_file << "\n";
+}
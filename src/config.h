@@ -0,0 +1,72 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Settings read at startup from presets, "key = value" files and command-line
+// flags, applied in the order given so that later ones override earlier ones.
+// Every key can be set as "--key value" on the command line, with dashes or
+// underscores, and boolean keys also as a bare "--key", which sets them.
+// Invalid keys or values throw invalid_argument; unreadable files throw runtime_error.
+struct Config {
+  // Window and board
+  std::size_t screen_width{640};
+  std::size_t screen_height{640};
+  std::size_t grid_width{32};
+  std::size_t grid_height{32};
+
+  // Timing: frames drawn and simulation ticks per second
+  double frames_per_second{60};
+  std::size_t ticks_per_second{60};
+
+  // Snake speed in cells per tick, and the speed gained with each normal food
+  float initial_speed{0.1f};
+  float speed_step{0.02f};
+
+  std::string high_score_file{"highscores.txt"};
+
+  std::string render_mode{"full"}; // full, incremental or texture
+  bool pipelined{false};
+  bool autopilot{false};
+  bool overlay{false};
+  std::optional<std::uint32_t> seed; // Drawn from random_device when unset
+  std::string profile_file;
+  std::string trace_file;
+  std::string record_file;
+  std::string replay_file;
+
+  // Names accepted by ApplyPreset
+  static std::vector<std::string> PresetNames();
+
+  // Resets every setting to its default, then applies the named preset:
+  // tiny, default, huge-board or benchmark
+  void ApplyPreset(std::string const &name);
+
+  // Sets one setting from its text form; "grid" sets both grid sizes
+  void Set(std::string const &key, std::string const &value);
+
+  // Applies a file of "key = value" lines; '#' starts a comment, "preset =
+  // name" applies a preset at that point
+  void Load(std::string const &file_name);
+
+  // Applies command-line arguments: "--preset name", "--config file",
+  // "--key value", "--flag" or "--flag <bool>", and the short forms --grid,
+  // --incremental, --texture, --profile, --trace, --record and --replay;
+  // then validates
+  void ParseArgs(std::vector<std::string> const &args);
+
+  // Checks the settings that depend on each other, which Set cannot check
+  // while they may still change: the initial speed must be less than the grid
+  void Validate() const;
+
+  // Writes every setting as a "key = value" line, each preceded by prefix,
+  // in a form Load accepts
+  void Write(std::ostream &out, char const *prefix = "") const;
+};
+
+#endif
@@ -1,41 +1,40 @@
 #include "controller.h"
+#include <chrono>
 #include <iostream>
 #include "SDL.h"
 #include "snake.h"
+#include "trace.h"
 
-void Controller::ChangeDirection(Snake &snake, Snake::Direction input,
-                                 Snake::Direction opposite) const {
-  if (snake.GetDirection() != opposite || snake.GetSize() == 1) snake.SetDirection(input);
-  return;
+void Controller::QueueDirection(InputQueue &queue, Snake::Direction input) const {
+  // A full queue means the player is far ahead of the snake; the press is dropped
+  queue.Push(InputCommand{input, std::chrono::steady_clock::now()});
 }
 
-void Controller::HandleInput(bool &running, Snake &snake) const {
+void Controller::HandleInput(bool &running, InputQueue &queue) const {
+  TRACE_SCOPE("Controller::HandleInput");
   SDL_Event e;
   while (SDL_PollEvent(&e)) {
     if (e.type == SDL_QUIT) {
       running = false;
-    } else if (e.type == SDL_KEYDOWN) {
+    } else if (e.type == SDL_KEYDOWN && !e.key.repeat) {
+      // Auto-repeat of a held key would only fill the queue with the same direction
       switch (e.key.keysym.sym) {
         case SDLK_UP:
-          ChangeDirection(snake, Snake::Direction::kUp,
-                          Snake::Direction::kDown);
+          QueueDirection(queue, Snake::Direction::kUp);
           break;
 
         case SDLK_DOWN:
-          ChangeDirection(snake, Snake::Direction::kDown,
-                          Snake::Direction::kUp);
+          QueueDirection(queue, Snake::Direction::kDown);
           break;
 
         case SDLK_LEFT:
-          ChangeDirection(snake, Snake::Direction::kLeft,
-                          Snake::Direction::kRight);
+          QueueDirection(queue, Snake::Direction::kLeft);
           break;
 
         case SDLK_RIGHT:
-          ChangeDirection(snake, Snake::Direction::kRight,
-                          Snake::Direction::kLeft);
+          QueueDirection(queue, Snake::Direction::kRight);
           break;
       }
     }
   }
-}
\ No newline at end of file
+}
@@ -1,16 +1,19 @@
 #ifndef CONTROLLER_H
 #define CONTROLLER_H
 
+#include "input_queue.h"
 #include "snake.h"
 #include <atomic>
 
 class Controller {
  public:
-  void HandleInput(bool &running, Snake &snake) const;
+  // Drains the SDL event queue. Every arrow key press is queued with its
+  // timestamp instead of turning the snake at once, so presses made within
+  // one frame are all kept; the game applies them one per cell step.
+  void HandleInput(bool &running, InputQueue &queue) const;
 
  private:
-  void ChangeDirection(Snake &snake, Snake::Direction input,
-                       Snake::Direction opposite) const;
+  void QueueDirection(InputQueue &queue, Snake::Direction input) const;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,100 @@
+#include "frame_pacer.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Bounds of the spin margin: below the minimum, sleeps that wake slightly
+// late start frames late; above the maximum, spinning wastes a core
+constexpr std::chrono::microseconds kMinSpin{200};
+constexpr std::chrono::microseconds kMaxSpin{4000};
+
+std::uint32_t Microseconds(FramePacer::Clock::duration d) {
+  return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+}
+
+}  // namespace
+
+// Constructor
+// The first frame is due one period from now
+FramePacer::FramePacer(double frames_per_second) : spin_margin(std::chrono::milliseconds(2)) {
+  if (frames_per_second <= 0) {
+    throw std::invalid_argument("Frame rate must be positive");
+  }
+  period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frames_per_second));
+  last_start = Clock::now();
+  deadline = last_start + period;
+}
+
+void FramePacer::Wait() {
+  Clock::time_point now = Clock::now();
+  if (!vsync) {
+    if (deadline - now > spin_margin) {
+      Clock::time_point wake = deadline - spin_margin;
+      std::this_thread::sleep_until(wake);
+      now = Clock::now();
+      oversleep_average += (now - wake - oversleep_average) / 8;
+      spin_margin = std::clamp<Clock::duration>(2 * oversleep_average, kMinSpin, kMaxSpin);
+    }
+    while (now < deadline) now = Clock::now();
+  }
+
+  Clock::duration interval = now - last_start;
+  Clock::duration error = interval > period ? interval - period : period - interval;
+  frames++;
+  if (2 * interval > 3 * period) late_frames++;
+  interval_total += interval;
+  error_total += error;
+  error_max = std::max(error_max, error);
+  error_histogram[std::min<std::size_t>(Microseconds(error) / kErrorBucketUs, kErrorBuckets - 1)]++;
+  last_start = now;
+
+  if (vsync && !vsync_reported) {
+    fast_streak = 10 * interval < 9 * period ? fast_streak + 1 : 0;
+    if (fast_streak >= kVsyncFrames) {
+      vsync = false;
+      vsync_ruled_out = true;
+    }
+  }
+
+  // Under vsync the display sets the schedule. A frame that started more
+  // than a period late restarts the schedule instead of rushing to catch up.
+  deadline += period;
+  if (vsync || now > deadline) deadline = now + period;
+}
+
+void FramePacer::AddPresent(Clock::duration duration) {
+  if (vsync_reported || vsync_ruled_out) return;
+  bool blocked = 4 * duration >= period;
+  present_streak = blocked != vsync ? present_streak + 1 : 0;
+  if (present_streak >= kVsyncFrames) {
+    vsync = blocked;
+    present_streak = 0;
+    fast_streak = 0;
+  }
+}
+
+void FramePacer::SetVsync(bool enabled) {
+  vsync_reported = enabled;
+  vsync = enabled;
+  present_streak = 0;
+}
+
+PacingStats FramePacer::Stats() const {
+  PacingStats stats{frames, late_frames, 0, 0, 0, Microseconds(error_max)};
+  if (frames == 0) return stats;
+  stats.mean_interval_us = Microseconds(interval_total / frames);
+  stats.mean_error_us = Microseconds(error_total / frames);
+  // Upper edge of the bucket holding the 99th percentile
+  std::size_t rank = (frames * 99 + 99) / 100;
+  std::size_t seen = 0;
+  for (std::size_t bucket = 0; bucket < kErrorBuckets; ++bucket) {
+    seen += error_histogram[bucket];
+    if (seen >= rank) {
+      stats.p99_error_us = std::min(static_cast<std::uint32_t>((bucket + 1) * kErrorBucketUs), stats.max_error_us);
+      break;
+    }
+  }
+  return stats;
+}
@@ -0,0 +1,80 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// How evenly frames were spaced: the pacing error of a frame is how far the
+// time since the previous frame started is from the target period
+struct PacingStats {
+  std::size_t frames; // Frame intervals measured
+  std::size_t late_frames; // Intervals longer than one and a half periods
+  std::uint32_t mean_interval_us;
+  std::uint32_t mean_error_us;
+  std::uint32_t p99_error_us;
+  std::uint32_t max_error_us;
+};
+
+// Starts frames at a fixed rate on a high-resolution clock. Wait sleeps for
+// most of the time left and spins for the rest, because a sleep can wake a
+// scheduler quantum late; the spin margin follows the oversleep measured.
+// Deadlines are absolute, so rounding never drifts the rate.
+// When the display paces frames itself (the renderer was created with vsync,
+// or presents keep blocking for a good part of a frame), Wait stops waiting
+// so the two do not add up and miss refreshes. If frames then come faster than
+// the target rate, the presents were just slow: Wait paces again and the
+// presents are no longer taken as a sign of vsync.
+class FramePacer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // Constructor
+  // Throws invalid_argument if frames_per_second is not positive
+  explicit FramePacer(double frames_per_second);
+
+  // Blocks until the next frame is due and records how late the frame starts
+  void Wait();
+
+  // Reports how long the last present blocked, to detect vsync from behaviour
+  void AddPresent(Clock::duration duration);
+
+  // Tells the pacer whether the renderer was created with vsync; if not,
+  // vsync forced by the driver is still detected from the presents
+  void SetVsync(bool enabled);
+
+  bool VsyncDetected() const { return vsync; }
+  Clock::duration Period() const { return period; }
+  Clock::duration SpinMargin() const { return spin_margin; }
+
+  // Statistics over every frame interval measured so far
+  PacingStats Stats() const;
+
+ private:
+  static constexpr int kErrorBucketUs = 50; // Width of one histogram bucket
+  static constexpr std::size_t kErrorBuckets = 1024; // The last bucket also holds larger errors
+  // Presents blocking for this many frames in a row, for at least a quarter
+  // of a period each, mean vsync is on; as many short ones in a row mean off
+  static constexpr int kVsyncFrames = 30;
+
+  Clock::duration period;
+  Clock::time_point deadline; // When the next frame is due
+  Clock::time_point last_start; // When the previous frame started
+  Clock::duration spin_margin; // Time left to spin after sleeping
+  Clock::duration oversleep_average{0}; // Moving average of how late sleeps wake
+  bool vsync{false};
+  bool vsync_reported{false}; // Set by SetVsync; overrides the present heuristics
+  int present_streak{0}; // Presents in a row that disagree with vsync
+  int fast_streak{0}; // Frames in a row shorter than the period while paced by vsync
+  bool vsync_ruled_out{false}; // Blocking presents turned out not to be vsync
+
+  std::size_t frames{0};
+  std::size_t late_frames{0};
+  Clock::duration interval_total{0};
+  Clock::duration error_total{0};
+  Clock::duration error_max{0};
+  std::array<std::uint32_t, kErrorBuckets> error_histogram{};
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "frame_profiler.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+char const *const kPhaseNames[FrameSample::kPhaseCount] = {"input", "update", "render"};
+char const kPhaseLetters[FrameSample::kPhaseCount] = {'I', 'U', 'R'};
+
+}  // namespace
+
+// Constructor
+// The ring and the statistics buffer are allocated once
+FrameProfiler::FrameProfiler() : samples(kCapacity) {
+  scratch.reserve(kCapacity);
+}
+
+// Single writer: the slot is filled before the new count is released
+void FrameProfiler::AddFrame(FrameSample const &sample) {
+  std::size_t index = written.load(std::memory_order_relaxed);
+  samples[index % kCapacity] = sample;
+  written.store(index + 1, std::memory_order_release);
+}
+
+void FrameProfiler::Gather(FrameSample::Phase phase, std::size_t first, std::size_t last) {
+  scratch.clear();
+  for (std::size_t i = first; i < last; ++i) {
+    scratch.push_back(samples[i % kCapacity].ns[phase]);
+  }
+}
+
+PhaseStats FrameProfiler::Stats(FrameSample::Phase phase, std::size_t frames) {
+  std::size_t last = FrameCount();
+  frames = std::min({frames, last, kCapacity});
+  if (frames == 0) return PhaseStats{0, 0, 0, 0};
+  Gather(phase, last - frames, last);
+
+  std::uint64_t total = 0;
+  for (std::uint32_t ns : scratch) total += ns;
+  PhaseStats stats;
+  stats.avg = static_cast<std::uint32_t>(total / scratch.size());
+  auto minmax = std::minmax_element(scratch.begin(), scratch.end());
+  stats.min = *minmax.first;
+  stats.max = *minmax.second;
+  auto p99 = scratch.begin() + static_cast<std::ptrdiff_t>(0.99 * (scratch.size() - 1));
+  std::nth_element(scratch.begin(), p99, scratch.end());
+  stats.p99 = *p99;
+  return stats;
+}
+
+void FrameProfiler::FormatOverlay(char *buffer, std::size_t size, std::size_t frames) {
+  std::size_t used = 0;
+  buffer[0] = '\0';
+  for (int phase = 0; phase < FrameSample::kPhaseCount && used < size; ++phase) {
+    PhaseStats stats = Stats(static_cast<FrameSample::Phase>(phase), frames);
+    int n = std::snprintf(buffer + used, size - used, "%c %u %u %u\n", kPhaseLetters[phase],
+                          stats.min / 1000, stats.avg / 1000, stats.p99 / 1000);
+    if (n < 0) break;
+    used += static_cast<std::size_t>(n);
+  }
+}
+
+bool FrameProfiler::Dump(std::string const &file_name) {
+  std::ofstream file(file_name);
+  if (!file) return false;
+  std::size_t last = FrameCount();
+  std::size_t first = last > kCapacity ? last - kCapacity : 0;
+  bool json = file_name.size() >= 5 && file_name.compare(file_name.size() - 5, 5, ".json") == 0;
+
+  if (!json) {
+    file << "frame,input_ns,update_ns,render_ns\n";
+    for (std::size_t i = first; i < last; ++i) {
+      FrameSample const &sample = samples[i % kCapacity];
+      file << i << ',' << sample.ns[FrameSample::kInput] << ',' << sample.ns[FrameSample::kUpdate] << ','
+           << sample.ns[FrameSample::kRender] << '\n';
+    }
+    return static_cast<bool>(file);
+  }
+
+  file << "{\n  \"frames\": " << last - first << ",\n  \"phases\": {";
+  for (int phase = 0; phase < FrameSample::kPhaseCount; ++phase) {
+    PhaseStats stats = Stats(static_cast<FrameSample::Phase>(phase), last - first);
+    file << (phase == 0 ? "\n" : ",\n") << "    \"" << kPhaseNames[phase] << "\": {\"min_ns\": " << stats.min
+         << ", \"avg_ns\": " << stats.avg << ", \"p99_ns\": " << stats.p99 << ", \"max_ns\": " << stats.max
+         << "}";
+  }
+  file << "\n  },\n  \"samples\": [";
+  for (std::size_t i = first; i < last; ++i) {
+    FrameSample const &sample = samples[i % kCapacity];
+    file << (i == first ? "\n" : ",\n") << "    [" << sample.ns[FrameSample::kInput] << ", "
+         << sample.ns[FrameSample::kUpdate] << ", " << sample.ns[FrameSample::kRender] << "]";
+  }
+  file << "\n  ]\n}\n";
+  return static_cast<bool>(file);
+}
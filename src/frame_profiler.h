@@ -0,0 +1,65 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Durations of the phases of one frame of the game loop, in nanoseconds
+struct FrameSample {
+  enum Phase { kInput, kUpdate, kRender, kPhaseCount };
+  std::array<std::uint32_t, kPhaseCount> ns;
+};
+
+// Summary of one phase over a run of frames, in nanoseconds
+struct PhaseStats {
+  std::uint32_t min;
+  std::uint32_t avg;
+  std::uint32_t p99;
+  std::uint32_t max;
+};
+
+// Keeps the phase timings of the most recent kCapacity frames in a ring.
+// The game loop publishes each frame with one atomic store and never
+// blocks, so the profiler can be read from another thread; a reader may see
+// the oldest frames being overwritten while it copies them.
+class FrameProfiler {
+ public:
+  static constexpr std::size_t kCapacity = 4096; // Power of two, about a minute at 60 FPS
+
+  // Constructor
+  FrameProfiler();
+
+  // Appends one frame, overwriting the oldest once the ring is full
+  void AddFrame(FrameSample const &sample);
+
+  // Number of frames recorded so far, including overwritten ones
+  std::size_t FrameCount() const { return written.load(std::memory_order_acquire); }
+
+  // Statistics of one phase over the last frames (at most kCapacity)
+  // Uses an internal buffer, so it is not safe to call from two threads at once
+  PhaseStats Stats(FrameSample::Phase phase, std::size_t frames);
+
+  // Writes one line per phase, "I", "U" or "R" followed by min, avg and p99 in
+  // microseconds over the last frames, into buffer; never allocates
+  void FormatOverlay(char *buffer, std::size_t size, std::size_t frames);
+
+  // Writes the frames still in the ring to file, as JSON with per-phase
+  // statistics if the name ends in ".json", as CSV otherwise
+  // Returns false if the file cannot be written
+  bool Dump(std::string const &file_name);
+
+ private:
+  // Copies the frames [first, last) of one phase into scratch
+  void Gather(FrameSample::Phase phase, std::size_t first, std::size_t last);
+
+  std::vector<FrameSample> samples; // Ring of kCapacity frames
+  std::atomic<std::size_t> written{0}; // Frames published so far
+  std::vector<std::uint32_t> scratch; // Work buffer for Stats
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef FRAME_SNAPSHOT_H
+#define FRAME_SNAPSHOT_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "SDL.h"
+#include "snake.h"
+
+// Everything the renderer draws, copied out of the game after a tick so the
+// render thread never reads state the simulation thread is changing
+struct FrameSnapshot {
+  // Body cells inside Renderer::GetView(head), the part of the board drawn,
+  // in no particular order; the head's current cell is not part of the body
+  std::vector<SDL_Point> body;
+  SDL_Point head{-1, -1}; // Cell the head is in
+  SDL_Point food{-1, -1};
+  SDL_Point bonus_food{-1, -1};
+  int bonus_food_remaining_time{0};
+  int score{0};
+  bool alive{true};
+  bool board_full{false};
+
+  // Head position before and after the tick in fixed point, to draw the head
+  // between the two; the previous one is not wrapped, as in Snake
+  std::int32_t prev_head_x{0};
+  std::int32_t prev_head_y{0};
+  std::int32_t head_x{0};
+  std::int32_t head_y{0};
+  int grid_width{0};
+  int grid_height{0};
+
+  std::uint64_t tick{0}; // Last simulated tick
+  std::chrono::steady_clock::time_point tick_time; // When that tick was simulated
+  std::uint32_t update_ns{0}; // Time spent in Game::Update since the previous snapshot
+
+  // Cell the head was in a fraction alpha of the way through the tick, as
+  // Snake::InterpolateHeadCell
+  SDL_Point InterpolateHeadCell(float alpha) const {
+    return Snake::InterpolateCell(prev_head_x, prev_head_y, head_x, head_y, alpha, grid_width, grid_height);
+  }
+};
+
+#endif
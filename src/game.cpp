@@ -1,154 +1,421 @@
 #include "game.h"
+#include <algorithm>
+#include <cassert>
 #include <iostream>
 #include "SDL.h"
 #include "high_score_manager.h"
-#include <mutex>
-#include <thread>
+#include "allocation_counter.h"
+#include "autopilot.h"
+#include "frame_pacer.h"
+#include "frame_profiler.h"
+#include "replay.h"
+#include "trace.h"
 #include <chrono>
-#include <condition_variable>
+#include <thread>
+
+namespace {
+
+// Default settings on a board of the given size and tick rate
+Config BoardConfig(std::size_t grid_width, std::size_t grid_height, std::size_t ticks_per_second) {
+  Config config;
+  config.grid_width = grid_width;
+  config.grid_height = grid_height;
+  config.ticks_per_second = ticks_per_second;
+  return config;
+}
+
+}  // namespace
 
 // Constructor
-// Initializes the game with a grid of specified width and height, and sets up the random number generators
-Game::Game(std::size_t grid_width, std::size_t grid_height)
-    : snake(grid_width, grid_height),
-      engine(dev()),
-      random_w(0, static_cast<int>(grid_width - 1)),
-      random_h(0, static_cast<int>(grid_height - 1)),
+// Initializes the game with a grid of specified width and height, and seeds the random number generator
+Game::Game(std::size_t grid_width, std::size_t grid_height, std::size_t ticks_per_second, std::uint32_t seed)
+    : Game(BoardConfig(grid_width, grid_height, ticks_per_second), seed) {}
+
+Game::Game(Config const &config, std::uint32_t seed)
+    : grid_width(static_cast<int>(config.grid_width)),
+      grid_height(static_cast<int>(config.grid_height)),
+      snake(grid_width, grid_height, config.initial_speed),
       bonus_food{-1, -1},
-      high_score_manager("highscores.txt") {
+      engine(seed),
+      ticks_per_second(config.ticks_per_second),
+      speed_step(Snake::ToFixed(config.speed_step)),
+      high_score_manager(config.high_score_file) {
+  dirty_cells.reserve(64);
   PlaceFood(); // Place the initial food
   high_score_manager.LoadHighScores(); // Load high scores from file
 }
 
 // Runs the main game loop: handles input, updates game state, and renders the game
-void Game::Run(Controller const &controller, Renderer &renderer,
-               std::size_t target_frame_duration) {
-  Uint32 title_timestamp = SDL_GetTicks();
-  Uint32 frame_start;
-  Uint32 frame_end;
-  Uint32 frame_duration;
+// The elapsed time of each frame is added to an accumulator that is consumed in
+// fixed simulation ticks, so the game speed does not depend on the frame rate.
+void Game::Run(Controller const &controller, Renderer &renderer, FramePacer &pacer) {
+  using Clock = std::chrono::steady_clock;
+  // Upper bound on ticks simulated per frame, so that a long stall does not
+  // make the simulation fall further and further behind
+  constexpr int kMaxTicksPerFrame = 8;
+  // The profiler overlay is refreshed this often and summarizes this many frames
+  constexpr int kOverlayRefreshFrames = 15;
+  constexpr std::size_t kOverlayWindowFrames = 240;
+  char overlay[128];
+  Clock::duration const tick_duration = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / ticks_per_second));
+
+  Clock::time_point title_timestamp = Clock::now();
+  Clock::time_point previous_frame_start = title_timestamp;
+  Clock::time_point frame_start;
+  Clock::time_point frame_end;
+  Clock::duration accumulator{0};
   int frame_count = 0;
   bool running = true;
+  pacer.SetVsync(renderer.HasVsync());
+  track_dirty_cells = true;
+#ifndef NDEBUG
+  // Debug builds assert that rendering makes no heap allocation on this
+  // thread; the render path only reads the snake through references. The
+  // first frame may allocate: it creates the render targets and, in tracing
+  // builds, this thread's 1.5 MB trace buffer.
+  bool first_frame = true;
+#endif
 
   while (running) {
-    frame_start = SDL_GetTicks();
+    frame_start = Clock::now();
+    accumulator += frame_start - previous_frame_start;
+    previous_frame_start = frame_start;
 
     // Input, Update, Render - the main game loop.
-    controller.HandleInput(running, snake);
-    Update();
-    renderer.Render(snake, food, bonus_food, bonus_food_remaining_time);
+    controller.HandleInput(running, input_queue);
+    Clock::time_point input_end = Clock::now();
+    int ticks = 0;
+    while (accumulator >= tick_duration && ticks < kMaxTicksPerFrame) {
+      Update();
+      accumulator -= tick_duration;
+      ticks++;
+    }
+    if (accumulator >= tick_duration) {
+      accumulator = tick_duration; // Drop the backlog the cap did not allow to run
+    }
+
+    // Fraction of the next tick already elapsed, used to draw the head that
+    // far between where the last two ticks left it; a finished game shows
+    // where the last tick left it
+    float alpha = std::chrono::duration<float>(accumulator) / tick_duration;
+    if (!snake.IsAlive() || board_full) alpha = 1.0f;
+    Clock::time_point update_end = Clock::now();
+#ifndef NDEBUG
+    std::size_t allocations_before_render = AllocationCounter::Count();
+#endif
+    renderer.Render(snake, food, bonus_food, bonus_food_remaining_time, dirty_cells, alpha);
+#ifndef NDEBUG
+    assert((first_frame || AllocationCounter::Count() == allocations_before_render) &&
+           "Renderer::Render allocated on the heap");
+    first_frame = false;
+#endif
+    dirty_cells.clear();
 
-    frame_end = SDL_GetTicks();
+    frame_end = Clock::now();
+
+    if (profiler != nullptr) {
+      auto ns = [](Clock::duration d) {
+        return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+      };
+      profiler->AddFrame(FrameSample{{ns(input_end - frame_start), ns(update_end - input_end),
+                                      ns(frame_end - update_end)}});
+      if (show_overlay && profiler->FrameCount() % kOverlayRefreshFrames == 0) {
+        profiler->FormatOverlay(overlay, sizeof(overlay), kOverlayWindowFrames);
+        renderer.SetOverlayText(overlay);
+      }
+    }
 
     // Keep track of how long each loop through the input/update/render cycle
     // takes.
     frame_count++;
-    frame_duration = frame_end - frame_start;
 
     // After every second, update the window title.
-    if (frame_end - title_timestamp >= 1000) {
+    if (frame_end - title_timestamp >= std::chrono::seconds(1)) {
       renderer.UpdateWindowTitle(score, frame_count);
       frame_count = 0;
       title_timestamp = frame_end;
     }
 
-    // If the time for this frame is too small (i.e. frame_duration is
-    // smaller than the target ms_per_frame), delay the loop to
-    // achieve the correct frame rate.
-    if (frame_duration < target_frame_duration) {
-      SDL_Delay(target_frame_duration - frame_duration);
-    }
+    // Wait for the next frame to be due
+    pacer.AddPresent(renderer.GetPresentDuration());
+    pacer.Wait();
 
     if (!running) {
-      std::string player_name;
-      std::cout << "Enter your name: ";
-      std::cin >> player_name;
-      high_score_manager.UpdateHighScores(player_name, score);
-      high_score_manager.PrintHighScores();
-      high_score_manager.SaveHighScores();
+      EndSession();
     }
   }
 }
 
+// The two threads share only the input queue and the triple buffer, both
+// lock-free. The profiler's update column holds the simulation time spent
+// since the previous snapshot drawn.
+void Game::RunPipelined(Controller const &controller, Renderer &renderer, FramePacer &pacer) {
+  using Clock = std::chrono::steady_clock;
+  constexpr int kOverlayRefreshFrames = 15;
+  constexpr std::size_t kOverlayWindowFrames = 240;
+  char overlay[128];
+  Clock::duration const tick_duration = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / ticks_per_second));
+
+  TripleBuffer<FrameSnapshot> frames;
+  FillSnapshot(frames.Back(), renderer);
+  frames.Publish();
+  frames.Consume();
+  std::atomic<bool> simulating{true};
+  std::thread simulation(&Game::SimulateLoop, this, std::cref(simulating), std::cref(renderer), std::ref(frames));
+
+  Clock::time_point title_timestamp = Clock::now();
+  int frame_count = 0;
+  bool running = true;
+  pacer.SetVsync(renderer.HasVsync());
+  while (running) {
+    Clock::time_point frame_start = Clock::now();
+    controller.HandleInput(running, input_queue);
+    Clock::time_point input_end = Clock::now();
+    bool fresh = frames.Consume();
+    FrameSnapshot const &frame = frames.Front();
+
+    float alpha = std::chrono::duration<float>(input_end - frame.tick_time) / tick_duration;
+    alpha = std::min(std::max(alpha, 0.0f), 1.0f);
+    if (!frame.alive || frame.board_full) alpha = 1.0f;
+    renderer.Render(frame, alpha);
+    Clock::time_point frame_end = Clock::now();
+
+    if (profiler != nullptr) {
+      auto ns = [](Clock::duration d) {
+        return static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+      };
+      profiler->AddFrame(FrameSample{{ns(input_end - frame_start), fresh ? frame.update_ns : 0,
+                                      ns(frame_end - input_end)}});
+      if (show_overlay && profiler->FrameCount() % kOverlayRefreshFrames == 0) {
+        profiler->FormatOverlay(overlay, sizeof(overlay), kOverlayWindowFrames);
+        renderer.SetOverlayText(overlay);
+      }
+    }
+
+    frame_count++;
+    if (frame_end - title_timestamp >= std::chrono::seconds(1)) {
+      renderer.UpdateWindowTitle(frame.score, frame_count);
+      frame_count = 0;
+      title_timestamp = frame_end;
+    }
+
+    pacer.AddPresent(renderer.GetPresentDuration());
+    pacer.Wait();
+  }
+
+  simulating.store(false, std::memory_order_relaxed);
+  simulation.join();
+  EndSession();
+}
+
+// Ticks are scheduled on absolute deadlines, so time spent publishing does
+// not drift the rate; after a stall of more than a few ticks the schedule
+// restarts from now instead of catching up in a burst.
+void Game::SimulateLoop(std::atomic<bool> const &running, Renderer const &renderer,
+                        TripleBuffer<FrameSnapshot> &frames) {
+  using Clock = std::chrono::steady_clock;
+  constexpr int kMaxTicksBehind = 8;
+  Clock::duration const tick_duration = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / ticks_per_second));
+
+  Clock::duration update_time{0};
+  Clock::time_point next_tick = Clock::now() + tick_duration;
+  while (running.load(std::memory_order_relaxed)) {
+    std::this_thread::sleep_until(next_tick);
+    Clock::time_point update_start = Clock::now();
+    Update();
+    Clock::time_point update_end = Clock::now();
+    update_time += update_end - update_start;
+
+    FrameSnapshot &frame = frames.Back();
+    FillSnapshot(frame, renderer);
+    frame.update_ns = static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(update_time).count());
+    frames.Publish();
+    update_time = Clock::duration{0};
+
+    next_tick += tick_duration;
+    if (update_end - next_tick > kMaxTicksBehind * tick_duration) next_tick = update_end + tick_duration;
+  }
+}
+
+// Only the body cells the renderer will show are copied: a snake shorter than
+// the view is filtered segment by segment, a longer one is read from the
+// occupancy chunks overlapping the view, so the cost is bounded by both the
+// length and the viewport. The body vector keeps its capacity across ticks.
+void Game::FillSnapshot(FrameSnapshot &frame, Renderer const &renderer) const {
+  TRACE_SCOPE("Game::FillSnapshot");
+  SDL_Point head = snake.GetHeadCell();
+  SDL_Rect view = renderer.GetView(head);
+  RingBuffer<SDL_Point> const &body = snake.GetBody();
+  frame.body.clear();
+  if (body.Size() < static_cast<std::size_t>(view.w) * view.h) {
+    for (SDL_Point const &point : body) {
+      if (point.x >= view.x && point.x < view.x + view.w && point.y >= view.y && point.y < view.y + view.h) {
+        frame.body.push_back(point);
+      }
+    }
+  } else {
+    snake.GetOccupancy().ForEachOccupied(view, [&](int x, int y) {
+      if (x != head.x || y != head.y) frame.body.push_back(SDL_Point{x, y});
+    });
+  }
+  frame.head = head;
+  frame.food = food;
+  frame.bonus_food = bonus_food;
+  frame.bonus_food_remaining_time = bonus_food_remaining_time;
+  frame.score = score;
+  frame.alive = snake.IsAlive();
+  frame.board_full = board_full;
+  frame.prev_head_x = snake.GetPrevHeadXFixed();
+  frame.prev_head_y = snake.GetPrevHeadYFixed();
+  frame.head_x = snake.GetHeadXFixed();
+  frame.head_y = snake.GetHeadYFixed();
+  frame.grid_width = grid_width;
+  frame.grid_height = grid_height;
+  frame.tick = tick;
+  frame.tick_time = std::chrono::steady_clock::now();
+}
+
+void Game::EndSession() {
+  if (input_latency_count > 0) {
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    std::cout << "Input-to-turn latency: mean "
+              << Milliseconds(input_latency_total).count() / input_latency_count << " ms, max "
+              << Milliseconds(input_latency_max).count() << " ms over " << input_latency_count
+              << " turns\n";
+  }
+  std::string player_name;
+  std::cout << "Enter your name: ";
+  std::cin >> player_name;
+  high_score_manager.UpdateHighScores(player_name, score);
+  high_score_manager.PrintHighScores();
+  high_score_manager.SaveHighScores();
+}
+
 // Places food at random location not occupied by the snake
+// The location is a single draw from the snake's free-cell set, so placement
+// takes constant time however much of the board the snake covers.
 void Game::PlaceFood() {
-  int x, y;
-  while (true) {
-    x = random_w(engine);
-    y = random_h(engine);
-    // Check that the location is not occupied by a snake item before placing
-    // food.
-    if (!snake.SnakeCell(x, y)) {
-      food.x = x;
-      food.y = y;
-      count_place_food++;
-      return;
-    }
+  TRACE_SCOPE("Game::PlaceFood");
+  if (!snake.GetOccupancy().RandomFreeCell(engine, food)) {
+    // The snake covers every cell: the game is won.
+    board_full = true;
+    food.x = -1;
+    food.y = -1;
+    return;
   }
+  count_place_food++;
 }
 
 // Places bonus food at random location not occupied by the snake and the normal food
-void Game::PlaceBonusFood() {
-  int x, y;
-  while (true) {
-    x = random_w(engine);
-    y = random_h(engine);
-    // Check that the location is not occupied by a snake item before placing
-    // food.
-    if ((!snake.SnakeCell(x, y)) && !(food.x == x && food.y == y)) {
-      bonus_food.x = x;
-      bonus_food.y = y;
-      return;
+bool Game::PlaceBonusFood() {
+  return snake.GetOccupancy().RandomFreeCell(engine, food, bonus_food);
+}
+
+// Bonus food stays on the board for this many seconds of simulation time
+constexpr int kBonusFoodSeconds = 6;
+
+// Fires the timed events due at the current tick and refreshes the bonus food remaining time
+void Game::HandleTimers() {
+  TimedEvent event;
+  while (timers.PopDue(tick, event)) {
+    switch (event.type) {
+      case TimedEventType::kBonusFoodExpired:
+        if (is_bonus_food_active && event.generation == bonus_food_generation) {
+          // Bonus food time is up
+          is_bonus_food_active = false;
+          bonus_food.x = -1;  // Mark as not present
+          bonus_food.y = -1;
+        }
+        break;
     }
   }
+
+  if (is_bonus_food_active) {
+    // Whole seconds left, rounded up, as the countdown shows 6 down to 1
+    std::uint64_t remaining_ticks = bonus_food_expiry_tick - tick;
+    bonus_food_remaining_time = static_cast<int>((remaining_ticks + ticks_per_second - 1) / ticks_per_second);
+  }
 }
 
-void Game::BonusFoodTimer() {
-  const int bonusSeconds = 6;
-  auto startTime = std::chrono::high_resolution_clock::now();
-  std::unique_lock<std::mutex> lock(mutex);
-  while (is_bonus_food_active) {
-    auto current_Time = std::chrono::high_resolution_clock::now();
-    auto elapsed_Seconds = std::chrono::duration_cast<std::chrono::seconds>(current_Time - startTime).count();
-
-    if (elapsed_Seconds >= bonusSeconds) {
-      // Bonus food time is up
-      is_bonus_food_active = false;
-      bonus_food.x = -1;  // Mark as not present
-      bonus_food.y = -1;
-      break;
-    }
+// Taking one turn per cell means two quick presses turn the snake on two
+// consecutive cells instead of the second overwriting the first. Presses
+// that would not change the direction, or would reverse the snake onto its
+// body, are dropped without using up the cell.
+void Game::ApplyQueuedInput() {
+  if (turned_in_cell) return;
+
+  InputCommand command;
+  while (input_queue.Pop(command)) {
+    Snake::Direction current = snake.GetDirection();
+    // Up/down and left/right are adjacent pairs in Direction
+    bool reverse = static_cast<int>(command.direction) == (static_cast<int>(current) ^ 1);
+    if (command.direction == current || (reverse && snake.GetSize() > 1)) continue;
 
-    bonus_food_remaining_time = bonusSeconds - static_cast<int>(elapsed_Seconds);
-    condition_var.wait_for(lock, std::chrono::milliseconds(800));
+    snake.SetDirection(command.direction);
+    turned_in_cell = true;
+    std::chrono::steady_clock::duration latency = std::chrono::steady_clock::now() - command.timestamp;
+    input_latency_count++;
+    input_latency_total += latency;
+    if (latency > input_latency_max) input_latency_max = latency;
+    return;
   }
 }
 
 // Updates the game state: moves the snake, check for collisions, and handles food consumption
 void Game::Update() {
-  if (!snake.IsAlive()) return;
+  TRACE_SCOPE("Game::Update");
+  // The cells changed by the previous update were there to be read until now
+  snake.ClearDirtyCells();
+  if (!snake.IsAlive() || board_full) return;
 
+  tick++;
+  // Steer before recording, so a replay reproduces the turns taken
+  if (autopilot != nullptr) {
+    input_queue.Clear();
+    snake.SetDirection(autopilot->NextDirection(snake, food));
+  } else {
+    ApplyQueuedInput();
+  }
+  if (recorder != nullptr) recorder->Record(tick, snake.GetDirection());
+  HandleTimers();
   snake.Update();
 
-  int new_x = static_cast<int>(snake.GetHeadX());
-  int new_y = static_cast<int>(snake.GetHeadY());
+  // The snake reports changed cells only when its head entered a new cell
+  if (!snake.GetDirtyCells().empty()) turned_in_cell = false;
+
+  // Hand the cells the snake changed over to the renderer, if Run draws them;
+  // headless drivers and the pipelined loop have no one to consume them
+  if (track_dirty_cells) {
+    dirty_cells.insert(dirty_cells.end(), snake.GetDirtyCells().begin(), snake.GetDirtyCells().end());
+  }
+
+  SDL_Point head = snake.GetHeadCell();
+  int new_x = head.x;
+  int new_y = head.y;
 
   if (food.x == new_x && food.y == new_y) {
     score++;
     PlaceFood();
     
-    if (count_place_food % 4 == 0) {
-      std::lock_guard<std::mutex> guard(mutex);
-      if (!is_bonus_food_active) {
-        PlaceBonusFood();
+    if (bonus_food_enabled && count_place_food % 4 == 0) {
+      if (!is_bonus_food_active && PlaceBonusFood()) {
         is_bonus_food_active = true;
-        bonusFoodThread = std::thread(&Game::BonusFoodTimer, this);
-        bonusFoodThread.detach();
+        bonus_food_generation++;
+        bonus_food_expiry_tick = tick + kBonusFoodSeconds * ticks_per_second;
+        bonus_food_remaining_time = kBonusFoodSeconds;
+        timers.Schedule(bonus_food_expiry_tick,
+                        TimedEvent{TimedEventType::kBonusFoodExpired, bonus_food_generation});
       }
     }
 
     snake.GrowBody();
-    snake.SetSpeed(snake.GetSpeed() + 0.02);
+    // Added up to the maximum only, so a large step cannot overflow the speed
+    std::int32_t headroom = snake.GetMaxSpeedFixed() - snake.GetSpeedFixed();
+    snake.SetSpeedFixed(snake.GetSpeedFixed() + std::min(speed_step, headroom));
   }
 
   if (bonus_food.x == new_x && bonus_food.y == new_y) {
@@ -163,4 +430,29 @@ void Game::Update() {
 // Returns the current score of the game
 int Game::GetScore() const { return score; }
 // Returns the current size of the snake
-int Game::GetSize() const { return snake.GetSize(); }
\ No newline at end of file
+int Game::GetSize() const { return snake.GetSize(); }
+// Returns true once the snake covers the whole board
+bool Game::IsBoardFull() const { return board_full; }
+// Returns the snake so headless drivers can steer it
+Snake &Game::GetSnake() { return snake; }
+// Returns the position of the food
+SDL_Point Game::GetFood() const { return food; }
+// Returns the position of bonus food, (-1, -1) if there is none
+SDL_Point Game::GetBonusFood() const { return bonus_food; }
+// Returns the cells the snake changed in the last update
+std::vector<SDL_Point> const &Game::GetChangedCells() const { return snake.GetDirtyCells(); }
+// Returns the number of ticks simulated so far
+std::uint64_t Game::GetTick() const { return tick; }
+// Starts or stops logging input to recorder
+void Game::SetRecorder(InputRecorder *recorder) { this->recorder = recorder; }
+// Returns the queue of key presses waiting to be applied
+InputQueue &Game::GetInputQueue() { return input_queue; }
+// Starts or stops timing the phases of each frame
+void Game::SetProfiler(FrameProfiler *profiler, bool show_overlay) {
+  this->profiler = profiler;
+  this->show_overlay = show_overlay;
+}
+// Starts or stops steering the snake automatically
+void Game::SetAutopilot(Autopilot *autopilot) { this->autopilot = autopilot; }
+// Starts or stops placing bonus food
+void Game::SetBonusFoodEnabled(bool enabled) { bonus_food_enabled = enabled; }
\ No newline at end of file
@@ -1,60 +1,156 @@
 #ifndef GAME_H
 #define GAME_H
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <random>
-#include <mutex>
-#include <thread>
-#include <condition_variable>
 #include "SDL.h"
+#include "config.h"
 #include "controller.h"
+#include "frame_snapshot.h"
 #include "renderer.h"
 #include "snake.h"
 #include "high_score_manager.h"
+#include "input_queue.h"
+#include "timer_queue.h"
+#include "triple_buffer.h"
+
+class Autopilot;
+class FramePacer;
+class FrameProfiler;
+class InputRecorder;
 
 class Game {
  public:
   // Constructor
   // Initialize the game by creating a grid with the size of grid times height, and setups the random number generator
-  Game(std::size_t grid_width, std::size_t grid_height);
-  // Runs the main game loop: handles input, updates game state, and renders the game
-  void Run(Controller const &controller, Renderer &renderer,
-           std::size_t target_frame_duration);
+  // The simulation advances ticks_per_second times per second regardless of the frame rate; the snake's
+  // speed is measured in cells per tick. The same seed and input always reproduce the same game.
+  Game(std::size_t grid_width, std::size_t grid_height, std::size_t ticks_per_second, std::uint32_t seed);
+  // Takes the board size, tick rate, snake speed, speed step and high score file from config
+  Game(Config const &config, std::uint32_t seed);
+  // Runs the main game loop: handles input, updates game state at a fixed timestep, and renders the game
+  // pacer starts each frame on time
+  void Run(Controller const &controller, Renderer &renderer, FramePacer &pacer);
+  // Same as Run, but the simulation runs on its own thread at the fixed
+  // timestep and publishes a snapshot after every tick; this thread handles
+  // input and draws the latest snapshot, so a slow present never delays a tick
+  void RunPipelined(Controller const &controller, Renderer &renderer, FramePacer &pacer);
   // Returns the current score of the game
   int GetScore() const;
   // Returns the current size of the snake
   int GetSize() const;
+  // Returns true once the snake covers the whole board and no food can be placed
+  bool IsBoardFull() const;
+
+  // Updates the game state by one fixed tick: moves the snake, check for collisions, and handles food consumption
+  // Run calls it from the main loop; headless drivers such as the benchmark call it directly
+  void Update();
+
+  // Gives headless drivers access to the snake to feed scripted input
+  Snake &GetSnake();
+
+  // Returns the position of the food and of bonus food, (-1, -1) if there is none
+  SDL_Point GetFood() const;
+  SDL_Point GetBonusFood() const;
+
+  // Returns the cells the snake changed in the last Update, as listed by
+  // Snake::GetDirtyCells; they are kept until the next Update, so an
+  // ObservationEncoder can patch its planes from them after every tick
+  std::vector<SDL_Point> const &GetChangedCells() const;
+
+  // Returns the number of ticks simulated so far
+  std::uint64_t GetTick() const;
+
+  // Logs the snake's direction at every tick to recorder; pass nullptr to stop recording
+  void SetRecorder(InputRecorder *recorder);
+
+  // Times input, update and render of every frame run by Run into profiler and,
+  // if show_overlay is set, shows their statistics on screen; pass nullptr to stop
+  void SetProfiler(FrameProfiler *profiler, bool show_overlay);
+
+  // Queue the controller fills with key presses; Update applies at most one
+  // queued turn per cell the snake's head enters
+  InputQueue &GetInputQueue();
+
+  // Lets autopilot steer the snake towards the food at every tick, overriding
+  // the keyboard; pass nullptr to hand control back to the player
+  void SetAutopilot(Autopilot *autopilot);
+
+  // Turns bonus food on (the default) or off; without it the game follows the
+  // rules of a VecEnv game, given one cell per tick and no speed step
+  void SetBonusFoodEnabled(bool enabled);
 
  private:
+  int grid_width; // The width of the grid
+  int grid_height; // The height of the grid
   Snake snake; // The snake objects representing the player's snake
   SDL_Point food; // The current position of the food
   SDL_Point bonus_food; // The current position of bonus food
 
-  std::random_device dev; // Random device for seeding the random number generator
   std::mt19937 engine; // Mersenne Twister random number generator
-  std::uniform_int_distribution<int> random_w; // Distribuion for random food placement on the x-axis
-  std::uniform_int_distribution<int> random_h; // Distribution for random food placement on the y-axis
-  std::mutex mutex; // Mutex 
-  std::condition_variable condition_var;
-  std::thread bonusFoodThread;
 
+  // Events scheduled on the simulation clock. The generation ties an event to
+  // one bonus food, so an expiry for bonus food that was already eaten is ignored.
+  enum class TimedEventType { kBonusFoodExpired };
+  struct TimedEvent {
+    TimedEventType type;
+    int generation;
+  };
+  TimerQueue<TimedEvent> timers; // Pending timed events, ordered by tick
+  std::uint64_t tick{0}; // Simulation time in ticks since the game started
+  InputRecorder *recorder{nullptr}; // Receives the input of every tick when set
+  Autopilot *autopilot{nullptr}; // Steers the snake when set
+  FrameProfiler *profiler{nullptr}; // Receives the phase timings of every frame when set
+  bool show_overlay{false}; // Draw the profiler statistics over the board
+  InputQueue input_queue; // Key presses waiting to be applied
+  bool turned_in_cell{false}; // A queued turn was applied since the head entered its cell
+
+  // Time from a key press to the tick that turned the snake
+  std::size_t input_latency_count{0};
+  std::chrono::steady_clock::duration input_latency_total{0};
+  std::chrono::steady_clock::duration input_latency_max{0};
+
+  std::size_t ticks_per_second; // The fixed simulation rate
+  std::int32_t speed_step; // Speed gained with each normal food, fixed point
   int score{0}; // The current score of the game
   int count_place_food{0}; // The counter of how many time normal food is placed
   int bonus_food_remaining_time{0}; // Initialization of the bonus food remaining time
+  bool bonus_food_enabled{true}; // Bonus food is placed at all
   bool is_bonus_food_active{false}; // The current status of bonus food
+  int bonus_food_generation{0}; // Incremented each time bonus food is placed
+  std::uint64_t bonus_food_expiry_tick{0}; // Tick at which the current bonus food disappears
+  bool board_full{false}; // Set when the snake fills every cell of the board
+  std::vector<SDL_Point> dirty_cells; // Cells changed since the last rendered frame
+  bool track_dirty_cells{false}; // Set by Run, the only loop that consumes dirty_cells
 
   // Places food at random location not occupied by the snake
+  // Marks the board as full if no such location is left
   void PlaceFood();
 
   // Places bonus food at random location not occupied by the snake and normal food
-  void PlaceBonusFood();
+  // Returns false if no such location is left
+  bool PlaceBonusFood();
 
-  // Timer before bonus food dissappear
-  void BonusFoodTimer();
+  // Turns the snake by the next queued key press that changes its direction,
+  // unless a turn was already applied in the head's current cell
+  void ApplyQueuedInput();
 
-  // Updates the game state: moves the snake, check for collisions, and handles food consumption
-  void Update();
+  // Fires the timed events due at the current tick and refreshes the bonus food remaining time
+  void HandleTimers();
+
+  // Simulation thread of RunPipelined: ticks at the fixed rate until running
+  // is cleared, publishing a snapshot into frames after every tick
+  void SimulateLoop(std::atomic<bool> const &running, Renderer const &renderer, TripleBuffer<FrameSnapshot> &frames);
+
+  // Copies what the renderer draws into frame
+  void FillSnapshot(FrameSnapshot &frame, Renderer const &renderer) const;
+
+  // Prints the session statistics, then asks for the player's name and saves the high scores
+  void EndSession();
 
-  HighScoreManager high_score_manager{"highscores.txt"}; // Manages the high scores
+  HighScoreManager high_score_manager; // Manages the high scores
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "head_kernel.h"
+#include "snake.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HEAD_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+HeadKernel::Isa HeadKernel::Detect() {
+  if (Supported(Isa::kAvx2)) return Isa::kAvx2;
+  if (Supported(Isa::kSse2)) return Isa::kSse2;
+  return Isa::kScalar;
+}
+
+bool HeadKernel::Supported(Isa isa) {
+  switch (isa) {
+    case Isa::kScalar:
+      return true;
+#ifdef HEAD_KERNEL_X86
+    case Isa::kSse2:
+      return __builtin_cpu_supports("sse2");
+    case Isa::kAvx2:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+char const *HeadKernel::Name(Isa isa) {
+  switch (isa) {
+    case Isa::kSse2:
+      return "sse2";
+    case Isa::kAvx2:
+      return "avx2";
+    default:
+      return "scalar";
+  }
+}
+
+// Falls back to the scalar path for an instruction set the CPU lacks
+void HeadKernel::Advance(Isa isa, HeadBatch const &batch, int begin, int end) {
+  if (!Supported(isa)) isa = Isa::kScalar;
+  switch (isa) {
+    case Isa::kAvx2:
+      AdvanceAvx2(batch, begin, end);
+      break;
+    case Isa::kSse2:
+      AdvanceSse2(batch, begin, end);
+      break;
+    default:
+      AdvanceScalar(batch, begin, end);
+      break;
+  }
+}
+
+void HeadKernel::AdvanceScalar(HeadBatch const &batch, int begin, int end) {
+  for (int i = begin; i < end; ++i) {
+    std::int32_t x = batch.x[i];
+    std::int32_t y = batch.y[i];
+    std::int32_t d = batch.direction[i];
+    std::int32_t nx = Snake::WrapFixed(x + Snake::kDirectionDx[d] * batch.speed[i], batch.width);
+    std::int32_t ny = Snake::WrapFixed(y + Snake::kDirectionDy[d] * batch.speed[i], batch.height);
+    bool alive = batch.alive[i] != 0;
+    batch.moved[i] = alive && ((nx ^ x) | (ny ^ y)) >> Snake::kFixedShift != 0;
+    batch.next_x[i] = alive ? nx : x;
+    batch.next_y[i] = alive ? ny : y;
+  }
+}
+
+#ifdef HEAD_KERNEL_X86
+
+namespace {
+
+// value + limit if value < 0, value - limit if value >= limit
+__attribute__((target("sse2"))) __m128i WrapSse2(__m128i value, __m128i limit) {
+  __m128i below = _mm_cmplt_epi32(value, _mm_setzero_si128());
+  value = _mm_add_epi32(value, _mm_and_si128(below, limit));
+  __m128i inside = _mm_cmplt_epi32(value, limit);
+  return _mm_sub_epi32(value, _mm_andnot_si128(inside, limit));
+}
+
+// mask ? a : b
+__attribute__((target("sse2"))) __m128i SelectSse2(__m128i mask, __m128i a, __m128i b) {
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+__attribute__((target("avx2"))) __m256i WrapAvx2(__m256i value, __m256i limit) {
+  __m256i below = _mm256_cmpgt_epi32(_mm256_setzero_si256(), value);
+  value = _mm256_add_epi32(value, _mm256_and_si256(below, limit));
+  __m256i inside = _mm256_cmpgt_epi32(limit, value);
+  return _mm256_sub_epi32(value, _mm256_andnot_si256(inside, limit));
+}
+
+}  // namespace
+
+// SSE2 has no 32-bit multiply, so the step along each axis is built from
+// direction compares: +speed for one direction, -speed for its opposite
+__attribute__((target("sse2")))
+void HeadKernel::AdvanceSse2(HeadBatch const &batch, int begin, int end) {
+  __m128i const width = _mm_set1_epi32(batch.width);
+  __m128i const height = _mm_set1_epi32(batch.height);
+  __m128i const up = _mm_set1_epi32(static_cast<int>(Snake::Direction::kUp));
+  __m128i const down = _mm_set1_epi32(static_cast<int>(Snake::Direction::kDown));
+  __m128i const left = _mm_set1_epi32(static_cast<int>(Snake::Direction::kLeft));
+  __m128i const right = _mm_set1_epi32(static_cast<int>(Snake::Direction::kRight));
+  __m128i const zero = _mm_setzero_si128();
+
+  int i = begin;
+  for (; i + 4 <= end; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(batch.x + i));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<__m128i const *>(batch.y + i));
+    __m128i d = _mm_loadu_si128(reinterpret_cast<__m128i const *>(batch.direction + i));
+    __m128i speed = _mm_loadu_si128(reinterpret_cast<__m128i const *>(batch.speed + i));
+    std::int32_t alive_bytes;
+    __builtin_memcpy(&alive_bytes, batch.alive + i, sizeof(alive_bytes));
+    __m128i alive = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(alive_bytes), zero), zero);
+    alive = _mm_cmpgt_epi32(alive, zero);
+
+    __m128i dx = _mm_sub_epi32(_mm_and_si128(_mm_cmpeq_epi32(d, right), speed),
+                               _mm_and_si128(_mm_cmpeq_epi32(d, left), speed));
+    __m128i dy = _mm_sub_epi32(_mm_and_si128(_mm_cmpeq_epi32(d, down), speed),
+                               _mm_and_si128(_mm_cmpeq_epi32(d, up), speed));
+    __m128i nx = WrapSse2(_mm_add_epi32(x, dx), width);
+    __m128i ny = WrapSse2(_mm_add_epi32(y, dy), height);
+
+    __m128i changed = _mm_srai_epi32(_mm_or_si128(_mm_xor_si128(nx, x), _mm_xor_si128(ny, y)),
+                                     Snake::kFixedShift);
+    __m128i moved = _mm_andnot_si128(_mm_cmpeq_epi32(changed, zero), alive);
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(moved));
+    for (int lane = 0; lane < 4; ++lane) {
+      batch.moved[i + lane] = (mask >> lane) & 1;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(batch.next_x + i), SelectSse2(alive, nx, x));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(batch.next_y + i), SelectSse2(alive, ny, y));
+  }
+  AdvanceScalar(batch, i, end);
+}
+
+// The step comes from permuting the direction tables by the direction of
+// each lane, then multiplying by the speed
+__attribute__((target("avx2")))
+void HeadKernel::AdvanceAvx2(HeadBatch const &batch, int begin, int end) {
+  __m256i const width = _mm256_set1_epi32(batch.width);
+  __m256i const height = _mm256_set1_epi32(batch.height);
+  __m256i const dx_table = _mm256_setr_epi32(Snake::kDirectionDx[0], Snake::kDirectionDx[1],
+                                             Snake::kDirectionDx[2], Snake::kDirectionDx[3], 0, 0, 0, 0);
+  __m256i const dy_table = _mm256_setr_epi32(Snake::kDirectionDy[0], Snake::kDirectionDy[1],
+                                             Snake::kDirectionDy[2], Snake::kDirectionDy[3], 0, 0, 0, 0);
+  __m256i const zero = _mm256_setzero_si256();
+
+  int i = begin;
+  for (; i + 8 <= end; i += 8) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(batch.x + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(batch.y + i));
+    __m256i d = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(batch.direction + i));
+    __m256i speed = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(batch.speed + i));
+    __m256i alive = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(batch.alive + i)));
+    alive = _mm256_cmpgt_epi32(alive, zero);
+
+    __m256i dx = _mm256_mullo_epi32(_mm256_permutevar8x32_epi32(dx_table, d), speed);
+    __m256i dy = _mm256_mullo_epi32(_mm256_permutevar8x32_epi32(dy_table, d), speed);
+    __m256i nx = WrapAvx2(_mm256_add_epi32(x, dx), width);
+    __m256i ny = WrapAvx2(_mm256_add_epi32(y, dy), height);
+
+    __m256i changed = _mm256_srai_epi32(_mm256_or_si256(_mm256_xor_si256(nx, x), _mm256_xor_si256(ny, y)),
+                                        Snake::kFixedShift);
+    __m256i moved = _mm256_andnot_si256(_mm256_cmpeq_epi32(changed, zero), alive);
+    int mask = _mm256_movemask_ps(_mm256_castsi256_ps(moved));
+    for (int lane = 0; lane < 8; ++lane) {
+      batch.moved[i + lane] = (mask >> lane) & 1;
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(batch.next_x + i), _mm256_blendv_epi8(x, nx, alive));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(batch.next_y + i), _mm256_blendv_epi8(y, ny, alive));
+  }
+  AdvanceScalar(batch, i, end);
+}
+
+#else
+
+void HeadKernel::AdvanceSse2(HeadBatch const &batch, int begin, int end) {
+  AdvanceScalar(batch, begin, end);
+}
+
+void HeadKernel::AdvanceAvx2(HeadBatch const &batch, int begin, int end) {
+  AdvanceScalar(batch, begin, end);
+}
+
+#endif
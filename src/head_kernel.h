@@ -0,0 +1,43 @@
+#ifndef HEAD_KERNEL_H
+#define HEAD_KERNEL_H
+
+#include <cstdint>
+
+// Heads of many snakes, as parallel arrays of fixed-point coordinates (see
+// Snake::kFixedShift). Input and output arrays must not overlap.
+struct HeadBatch {
+  std::int32_t const *x;
+  std::int32_t const *y;
+  std::int32_t const *direction; // Snake::Direction as int
+  std::int32_t const *speed;
+  std::uint8_t const *alive;
+  std::int32_t *next_x;
+  std::int32_t *next_y;
+  std::uint8_t *moved; // Set to 1 when a live head entered a new cell, else 0
+  std::int32_t width; // Board width in fixed point
+  std::int32_t height; // Board height in fixed point
+};
+
+// Advances a batch of heads by one update with the same arithmetic as
+// Snake::UpdateHead: a direction table gives the step and the result is
+// wrapped onto the board by compare-and-select. Dead heads keep their
+// position. Every instruction set produces bit-identical results.
+class HeadKernel {
+ public:
+  enum class Isa { kScalar, kSse2, kAvx2 };
+
+  // Widest instruction set the running CPU supports
+  static Isa Detect();
+  static bool Supported(Isa isa);
+  static char const *Name(Isa isa);
+
+  // Advances heads [begin, end) of the batch
+  static void Advance(Isa isa, HeadBatch const &batch, int begin, int end);
+
+ private:
+  static void AdvanceScalar(HeadBatch const &batch, int begin, int end);
+  static void AdvanceSse2(HeadBatch const &batch, int begin, int end);
+  static void AdvanceAvx2(HeadBatch const &batch, int begin, int end);
+};
+
+#endif
@@ -0,0 +1,23 @@
+#include "input_queue.h"
+
+// The release store publishes the command before the consumer can see the new tail
+bool InputQueue::Push(InputCommand const &command) {
+  std::size_t back = tail.load(std::memory_order_relaxed);
+  if (back - head.load(std::memory_order_acquire) == kCapacity) return false;
+  commands[back % kCapacity] = command;
+  tail.store(back + 1, std::memory_order_release);
+  return true;
+}
+
+// The release store hands the slot back to the producer only after it was read
+bool InputQueue::Pop(InputCommand &command) {
+  std::size_t front = head.load(std::memory_order_relaxed);
+  if (front == tail.load(std::memory_order_acquire)) return false;
+  command = commands[front % kCapacity];
+  head.store(front + 1, std::memory_order_release);
+  return true;
+}
+
+void InputQueue::Clear() {
+  head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+}
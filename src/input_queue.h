@@ -0,0 +1,42 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include "snake.h"
+
+// A direction key press and the moment it was read from the event queue
+struct InputCommand {
+  Snake::Direction direction;
+  std::chrono::steady_clock::time_point timestamp;
+};
+
+// Fixed-capacity queue of key presses between one producer (the event pump)
+// and one consumer (the simulation). Push and Pop never block, allocate or
+// take a lock, so the two sides may run on different threads.
+class InputQueue {
+ public:
+  static constexpr std::size_t kCapacity = 16; // Power of two
+
+  // Adds a command at the back
+  // Returns false and drops the command if the queue is full
+  bool Push(InputCommand const &command);
+
+  // Removes the command at the front into command
+  // Returns false if the queue is empty
+  bool Pop(InputCommand &command);
+
+  // Discards every queued command; consumer side only
+  void Clear();
+
+ private:
+  std::array<InputCommand, kCapacity> commands;
+  // Free-running counters, only the low bits index commands. Each is written
+  // by one side and kept on its own cache line.
+  alignas(64) std::atomic<std::size_t> head{0}; // Next command to pop
+  alignas(64) std::atomic<std::size_t> tail{0}; // Next free slot
+};
+
+#endif
@@ -1,23 +1,133 @@
+#include <cstdint>
 #include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "autopilot.h"
 #include "controller.h"
+#include "frame_pacer.h"
+#include "frame_profiler.h"
 #include "game.h"
 #include "renderer.h"
+#include "replay.h"
 #include "snake.h"
+#include "trace.h"
 
-int main() {
-    constexpr std::size_t kFramesPerSecond{60};
-    constexpr std::size_t kMsPerFrame{1000 / kFramesPerSecond};
-    constexpr std::size_t kScreenWidth{640};
-    constexpr std::size_t kScreenHeight{640};
-    constexpr std::size_t kGridWidth{32};
-    constexpr std::size_t kGridHeight{32};
+int main(int argc, char *argv[]) {
+    // Settings come from presets, config files and flags, applied in order;
+    // see config.h and the README for the keys. --print-config writes the
+    // resulting settings in config-file form and exits.
+    // --render-mode incremental (or --incremental) repaints only the cells
+    // that changed each frame, texture (or --texture) draws the board as one
+    // texel per cell scaled to the window
+    // --seed <n> fixes the random seed, --record <file> saves the session,
+    // --replay <file> re-runs a saved session headlessly and checks its result
+    // --pipelined runs the simulation on its own thread, so rendering never delays it
+    // --autopilot lets the game steer the snake to the food by itself
+    // --overlay shows per-phase frame timings, --profile <file> writes them
+    // to a CSV file, or JSON if the name ends in .json, at exit
+    // --trace <file> writes a Chrome trace at exit (builds with SNAKE_TRACING)
+    // --grid <n> plays on an n x n board; boards too large for the window
+    // are shown through a camera that follows the snake
+    Config config;
+    bool print_config = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--print-config") {
+            print_config = true;
+        } else {
+            args.push_back(arg);
+        }
+    }
+    try {
+        config.ParseArgs(args);
+    } catch (std::exception const &error) {
+        std::cerr << error.what() << "\n";
+        return 1;
+    }
+    if (print_config) {
+        config.Write(std::cout);
+        return 0;
+    }
 
-    Renderer renderer(kScreenWidth, kScreenHeight, kGridWidth, kGridHeight);
+    Renderer::Mode render_mode = Renderer::Mode::kFull;
+    if (config.render_mode == "incremental") render_mode = Renderer::Mode::kIncremental;
+    if (config.render_mode == "texture") render_mode = Renderer::Mode::kTexture;
+    std::uint32_t seed = config.seed ? *config.seed : std::random_device{}();
+    std::string const &profile_file = config.profile_file;
+    std::string const &trace_file = config.trace_file;
+    std::string const &record_file = config.record_file;
+    std::string const &replay_file = config.replay_file;
+
+    if (!replay_file.empty()) {
+        ReplaySession replay;
+        if (!replay.Load(replay_file)) {
+            std::cerr << "Could not read replay file " << replay_file << "\n";
+            return 1;
+        }
+        bool matches = replay.Run();
+        std::cout << "Replayed " << replay.GetTotalTicks() << " ticks at "
+                  << static_cast<long long>(replay.GetTicksPerSecond()) << " ticks/s\n";
+        std::cout << "Score: " << replay.GetScore() << " (recorded " << replay.GetRecordedScore() << ")\n";
+        std::cout << "Size: " << replay.GetSize() << " (recorded " << replay.GetRecordedSize() << ")\n";
+        std::cout << (matches ? "Replay matches the recording.\n" : "Replay does NOT match the recording!\n");
+        return matches ? 0 : 1;
+    }
+
+    Renderer renderer(config.screen_width, config.screen_height, config.grid_width, config.grid_height, render_mode);
     Controller controller;
-    Game game(kGridWidth, kGridHeight);
-    game.Run(controller, renderer, kMsPerFrame);
+    Game game(config, seed);
+    InputRecorder recorder(seed, config);
+    if (!record_file.empty()) game.SetRecorder(&recorder);
+    // The autopilot sizes its search buffers for the whole board, so it is only built when used
+    std::optional<Autopilot> autopilot;
+    if (config.autopilot) {
+        autopilot.emplace(config.grid_width, config.grid_height);
+        game.SetAutopilot(&*autopilot);
+    }
+    FrameProfiler profiler;
+    if (config.overlay || !profile_file.empty()) game.SetProfiler(&profiler, config.overlay);
+    FramePacer pacer(config.frames_per_second);
+    if (config.pipelined) {
+        game.RunPipelined(controller, renderer, pacer);
+    } else {
+        game.Run(controller, renderer, pacer);
+    }
     std::cout << "Game has terminated successfully!\n";
+    if (game.IsBoardFull()) std::cout << "You win: the snake fills the whole board!\n";
+    std::cout << "Seed: " << seed << "\n";
     std::cout << "Score: " << game.GetScore() << "\n";
     std::cout << "Size: " << game.GetSize() << "\n";
+    PacingStats pacing = pacer.Stats();
+    std::cout << "Frame pacing: " << pacing.frames << " frames, mean interval " << pacing.mean_interval_us
+              << " us, error mean " << pacing.mean_error_us << " us, p99 " << pacing.p99_error_us << " us, max "
+              << pacing.max_error_us << " us, " << pacing.late_frames << " late"
+              << (pacer.VsyncDetected() ? ", paced by vsync" : "") << "\n";
+    if (!profile_file.empty()) {
+        if (profiler.Dump(profile_file)) {
+            std::cout << "Frame timings written to " << profile_file << "\n";
+        } else {
+            std::cerr << "Could not write " << profile_file << "\n";
+        }
+    }
+    if (!trace_file.empty()) {
+        if (!Trace::Enabled()) {
+            std::cerr << "Tracing is not compiled in; configure with -DSNAKE_TRACING=ON\n";
+        } else if (Trace::Write(trace_file)) {
+            std::cout << "Trace written to " << trace_file << "\n";
+        } else {
+            std::cerr << "Could not write " << trace_file << "\n";
+        }
+    }
+    if (!record_file.empty()) {
+        if (recorder.Save(record_file, game.GetTick(), game.GetScore(), game.GetSize())) {
+            std::cout << "Session recorded to " << record_file << "\n";
+        } else {
+            std::cerr << "Could not write " << record_file << "\n";
+        }
+    }
     return 0;
 }
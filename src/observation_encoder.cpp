@@ -0,0 +1,57 @@
+#include "observation_encoder.h"
+#include <algorithm>
+
+// Constructor
+ObservationEncoder::ObservationEncoder(int grid_width, int grid_height)
+  : grid_width(grid_width), grid_height(grid_height) {}
+
+void ObservationEncoder::Encode(Snake const &snake, SDL_Point const &food,
+                                SDL_Point const &bonus_food, std::uint8_t *planes) {
+  int cells = grid_width * grid_height;
+  std::fill(planes, planes + Size(), 0);
+  drawn_head = Index(snake.GetHeadCell());
+  for (SDL_Point const &cell : snake.GetBody()) {
+    WriteSnakeCell(planes, cells, Index(cell), drawn_head, true);
+  }
+  WriteSnakeCell(planes, cells, drawn_head, drawn_head, true);
+
+  drawn_food = -1;
+  drawn_bonus_food = -1;
+  MoveMarker(planes, cells, kFoodPlane, drawn_food, Index(food));
+  MoveMarker(planes, cells, kBonusFoodPlane, drawn_bonus_food, Index(bonus_food));
+}
+
+// The previous head is repainted as well, so a head that moved without a
+// matching dirty cell still leaves no stale marker
+void ObservationEncoder::Update(Snake const &snake, SDL_Point const &food,
+                                SDL_Point const &bonus_food,
+                                std::vector<SDL_Point> const &dirty_cells, std::uint8_t *planes) {
+  int cells = grid_width * grid_height;
+  OccupancyGrid const &occupancy = snake.GetOccupancy();
+  int head = Index(snake.GetHeadCell());
+  for (SDL_Point const &cell : dirty_cells) {
+    WriteSnakeCell(planes, cells, Index(cell), head, occupancy.IsOccupied(cell.x, cell.y));
+  }
+  if (drawn_head >= 0) WriteSnakeCell(planes, cells, drawn_head, head, occupancy.IsOccupied(drawn_head));
+  WriteSnakeCell(planes, cells, head, head, true);
+  drawn_head = head;
+
+  MoveMarker(planes, cells, kFoodPlane, drawn_food, Index(food));
+  MoveMarker(planes, cells, kBonusFoodPlane, drawn_bonus_food, Index(bonus_food));
+}
+
+// Any covered cell other than the head holds a body segment
+void ObservationEncoder::WriteSnakeCell(std::uint8_t *planes, int cell_count, int cell, int head_cell,
+                                        bool covered) {
+  bool is_head = cell == head_cell;
+  planes[kHeadPlane * cell_count + cell] = is_head;
+  planes[kBodyPlane * cell_count + cell] = !is_head && covered;
+}
+
+void ObservationEncoder::MoveMarker(std::uint8_t *planes, int cell_count, Plane plane, std::int32_t &drawn,
+                                    int cell) {
+  if (drawn == cell) return;
+  if (drawn >= 0) planes[plane * cell_count + drawn] = 0;
+  if (cell >= 0) planes[plane * cell_count + cell] = 1;
+  drawn = cell;
+}
@@ -0,0 +1,60 @@
+#ifndef OBSERVATION_ENCODER_H
+#define OBSERVATION_ENCODER_H
+
+#include <cstdint>
+#include <vector>
+#include "SDL.h"
+#include "snake.h"
+
+// Writes the board of one game into caller-owned memory as kPlaneCount
+// planes of grid_height x grid_width bytes, each byte 0 or 1. The head cell
+// is only ever marked in the head plane, never in the body plane.
+//
+// Encode rebuilds every plane. Update patches the planes written by the
+// previous Encode or Update from the cells the snake changed and from the
+// food that moved, so its cost does not grow with the snake or the board.
+// An encoder tracks one set of planes; use one encoder per game.
+class ObservationEncoder {
+ public:
+  enum Plane { kBodyPlane, kHeadPlane, kFoodPlane, kBonusFoodPlane, kPlaneCount };
+
+  // Constructor
+  ObservationEncoder(int grid_width, int grid_height);
+
+  // Bytes written per observation
+  int Size() const { return kPlaneCount * grid_width * grid_height; }
+
+  // Rewrites all of planes. Food at (-1, -1) is not on the board.
+  void Encode(Snake const &snake, SDL_Point const &food, SDL_Point const &bonus_food,
+              std::uint8_t *planes);
+
+  // Brings planes up to date; dirty_cells lists the cells the snake changed
+  // since planes were last written, as reported by Game::GetChangedCells
+  // after every Game::Update, or by Snake::GetDirtyCells for a bare snake
+  void Update(Snake const &snake, SDL_Point const &food, SDL_Point const &bonus_food,
+              std::vector<SDL_Point> const &dirty_cells, std::uint8_t *planes);
+
+  // The steps Encode and Update are made of, on the planes of a board of
+  // cell_count cells with cells given as row-major indices, -1 for none.
+  // VecEnv applies them directly to the flat state of its games.
+
+  // Rewrites the body and head bytes of cell, which the snake covers or not
+  static void WriteSnakeCell(std::uint8_t *planes, int cell_count, int cell, int head_cell, bool covered);
+
+  // Moves the single marker of a food plane from cell drawn to cell, and
+  // sets drawn to cell
+  static void MoveMarker(std::uint8_t *planes, int cell_count, Plane plane, std::int32_t &drawn, int cell);
+
+ private:
+  int Index(SDL_Point const &cell) const { return cell.x >= 0 ? cell.y * grid_width + cell.x : -1; }
+
+  int grid_width;
+  int grid_height;
+
+  // Cells marked in the head and food planes by the last call, -1 if none
+  std::int32_t drawn_head{-1};
+  std::int32_t drawn_food{-1};
+  std::int32_t drawn_bonus_food{-1};
+};
+
+#endif
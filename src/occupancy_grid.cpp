@@ -0,0 +1,87 @@
+#include "occupancy_grid.h"
+
+// Constructor
+// Allocates one counter per cell so lookups never walk the snake's body, and
+// starts with every cell in the free set
+OccupancyGrid::OccupancyGrid(int grid_width, int grid_height)
+  : grid_width(grid_width),
+    grid_height(grid_height),
+    cells(static_cast<std::size_t>(grid_width) * grid_height),
+    free_cells(cells.size()),
+    free_slot(cells.size()),
+    chunk_columns((grid_width + kChunkSize - 1) >> kChunkShift),
+    chunk_rows((grid_height + kChunkSize - 1) >> kChunkShift),
+    chunk_counts(static_cast<std::size_t>(chunk_columns) * chunk_rows, 0) {
+  Slice().Clear(static_cast<int>(cells.size()));
+}
+
+// The chunk counts follow the cells that change between free and occupied
+void OccupancyGrid::Occupy(int index) {
+  if (Slice().Occupy(index)) chunk_counts[Chunk(index)]++;
+}
+
+void OccupancyGrid::Vacate(int index) {
+  if (Slice().Vacate(index)) chunk_counts[Chunk(index)]--;
+}
+
+bool OccupancyGrid::RandomFreeCell(std::mt19937 &engine, SDL_Point &cell) const {
+  int index = OccupancySlice::PickFree(free_cells.data(), free_count, engine);
+  if (index < 0) return false;
+  cell = Cell(index);
+  return true;
+}
+
+// Draws from all free cells but the last one; if the draw lands on the
+// excluded cell, the last cell takes its place. Every other free cell keeps
+// the same probability.
+bool OccupancyGrid::RandomFreeCell(std::mt19937 &engine, SDL_Point const &exclude,
+                                   SDL_Point &cell) const {
+  bool exclude_is_free = exclude.x >= 0 && exclude.x < grid_width &&
+                         exclude.y >= 0 && exclude.y < grid_height &&
+                         !IsOccupied(exclude.x, exclude.y);
+  if (!exclude_is_free) return RandomFreeCell(engine, cell);
+  if (free_count < 2) return false;
+
+  int last = free_count - 1;
+  std::uniform_int_distribution<int> pick(0, last - 1);
+  int index = free_cells[pick(engine)];
+  if (index == Index(exclude.x, exclude.y)) index = free_cells[last];
+  cell = Cell(index);
+  return true;
+}
+
+void OccupancySlice::Clear(int cell_count) const {
+  for (int index = 0; index < cell_count; ++index) {
+    cells[index] = 0;
+    free_cells[index] = index;
+    free_slot[index] = index;
+  }
+  *free_count = cell_count;
+}
+
+// A cell can hold two segments for one step when the head runs into the body.
+// Swap-remove: the last free cell fills the hole left by index.
+bool OccupancySlice::Occupy(int index) const {
+  if (cells[index]++ != 0) return false;
+  int slot = free_slot[index];
+  int moved = free_cells[*free_count - 1];
+  free_cells[slot] = moved;
+  free_slot[moved] = slot;
+  --*free_count;
+  free_slot[index] = -1;
+  return true;
+}
+
+bool OccupancySlice::Vacate(int index) const {
+  if (--cells[index] != 0) return false;
+  free_slot[index] = *free_count;
+  free_cells[*free_count] = index;
+  ++*free_count;
+  return true;
+}
+
+int OccupancySlice::PickFree(std::int32_t const *free_cells, int free_count, std::mt19937 &engine) {
+  if (free_count == 0) return -1;
+  std::uniform_int_distribution<int> pick(0, free_count - 1);
+  return free_cells[pick(engine)];
+}
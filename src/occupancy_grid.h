@@ -0,0 +1,125 @@
+#ifndef OCCUPANCY_GRID_H
+#define OCCUPANCY_GRID_H
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "SDL.h"
+
+// The cell counters and free-cell list of one board, in storage the caller
+// owns. OccupancyGrid keeps one over its own vectors and VecEnv one per game
+// over slices of buffers shared by all its games, so both place food and
+// track the snake by the same rules. A copy refers to the same storage.
+struct OccupancySlice {
+  std::uint8_t *cells; // Number of snake segments in each cell
+  std::int32_t *free_cells; // Dense list of free cell indices
+  std::int32_t *free_slot; // Position of each cell in free_cells, -1 if occupied
+  std::int32_t *free_count; // Number of entries in free_cells
+
+  // Marks all cell_count cells of the board free
+  void Clear(int cell_count) const;
+
+  // Adds one snake segment to the cell; returns true if the cell was free
+  bool Occupy(int index) const;
+
+  // Removes one snake segment from the cell; returns true if it is now free
+  bool Vacate(int index) const;
+
+  bool IsOccupied(int index) const { return cells[index] != 0; }
+
+  // Picks a free cell index uniformly at random with a single draw
+  // Returns -1 if no cell is free
+  int RandomFree(std::mt19937 &engine) const { return PickFree(free_cells, *free_count, engine); }
+
+  // The draw behind RandomFree, over a free-cell list that may be read-only
+  static int PickFree(std::int32_t const *free_cells, int free_count, std::mt19937 &engine);
+};
+
+class OccupancyGrid {
+ public:
+  // Constructor
+  // Creates an empty grid of the given width and height
+  OccupancyGrid(int grid_width, int grid_height);
+
+  // Marks the cell as occupied by one more snake segment
+  void Occupy(int x, int y) { Occupy(Index(x, y)); }
+  void Occupy(int index);
+
+  // Releases one snake segment from the cell
+  void Vacate(int x, int y) { Vacate(Index(x, y)); }
+  void Vacate(int index);
+
+  // Checks if the cell is occupied by at least one snake segment
+  bool IsOccupied(int x, int y) const { return IsOccupied(Index(x, y)); }
+  bool IsOccupied(int index) const { return cells[index] != 0; }
+
+  // Row-major index of a cell, the form the index overloads above take
+  int Index(int x, int y) const { return y * grid_width + x; }
+
+  // The grid is also split into square chunks of kChunkSize cells a side,
+  // each with a count of its occupied cells, so a renderer can skip empty
+  // regions without looking at their cells
+  static constexpr int kChunkShift = 5;
+  static constexpr int kChunkSize = 1 << kChunkShift;
+  int ChunkColumns() const { return chunk_columns; }
+  int ChunkRows() const { return chunk_rows; }
+  // Number of occupied cells in chunk (chunk_x, chunk_y)
+  int ChunkCount(int chunk_x, int chunk_y) const { return chunk_counts[chunk_y * chunk_columns + chunk_x]; }
+
+  // Calls visit(x, y) for every occupied cell inside rect, which must lie on
+  // the grid, row by row within each chunk; empty chunks are skipped unread
+  template <typename Visit>
+  void ForEachOccupied(SDL_Rect const &rect, Visit &&visit) const {
+    int last_x = rect.x + rect.w - 1;
+    int last_y = rect.y + rect.h - 1;
+    for (int chunk_y = rect.y >> kChunkShift; chunk_y <= last_y >> kChunkShift; ++chunk_y) {
+      for (int chunk_x = rect.x >> kChunkShift; chunk_x <= last_x >> kChunkShift; ++chunk_x) {
+        if (ChunkCount(chunk_x, chunk_y) == 0) continue;
+        int y_end = std::min((chunk_y + 1) << kChunkShift, last_y + 1);
+        int x_begin = std::max(chunk_x << kChunkShift, rect.x);
+        int x_end = std::min((chunk_x + 1) << kChunkShift, last_x + 1);
+        for (int y = std::max(chunk_y << kChunkShift, rect.y); y < y_end; ++y) {
+          for (int x = x_begin; x < x_end; ++x) {
+            if (IsOccupied(x, y)) visit(x, y);
+          }
+        }
+      }
+    }
+  }
+
+  // Returns the number of cells not occupied by any snake segment
+  int FreeCount() const { return free_count; }
+
+  // Picks a free cell uniformly at random with a single draw
+  // Returns false and leaves cell untouched if no cell is free
+  bool RandomFreeCell(std::mt19937 &engine, SDL_Point &cell) const;
+
+  // Same as above, but never returns the exclude cell
+  bool RandomFreeCell(std::mt19937 &engine, SDL_Point const &exclude,
+                      SDL_Point &cell) const;
+
+ private:
+  SDL_Point Cell(int index) const {
+    return SDL_Point{index % grid_width, index / grid_width};
+  }
+
+  int Chunk(int index) const {
+    return (index / grid_width >> kChunkShift) * chunk_columns + (index % grid_width >> kChunkShift);
+  }
+
+  // The counters and free-cell list below, as a slice
+  OccupancySlice Slice() { return OccupancySlice{cells.data(), free_cells.data(), free_slot.data(), &free_count}; }
+
+  int grid_width; // The width of the grid
+  int grid_height; // The height of the grid
+  std::vector<std::uint8_t> cells; // Number of snake segments in each cell
+  std::vector<std::int32_t> free_cells; // Dense list of free cell indices, free_count long
+  std::vector<std::int32_t> free_slot; // Position of each cell in free_cells, -1 if occupied
+  std::int32_t free_count{0};
+  int chunk_columns;
+  int chunk_rows;
+  std::vector<int> chunk_counts; // Occupied cells per chunk, row-major
+};
+
+#endif
@@ -2,6 +2,22 @@
 #include <iostream>
 #include <string>
 #include <algorithm>  // For std::copy
+#include <cstring>
+#include "trace.h"
+
+namespace {
+
+// Layer colours as 0xAARRGGBB, the layout of an ARGB8888 texel
+constexpr Uint32 kBackgroundColour = 0xFF1E1E1E;
+constexpr Uint32 kFoodColour = 0xFFFFCC00;
+constexpr Uint32 kBonusFoodColour = 0xFF00FF00; // Green color for bonus food
+constexpr Uint32 kBodyColour = 0xFFFFFFFF;
+constexpr Uint32 kHeadColour = 0xFF007ACC;
+constexpr Uint32 kDeadHeadColour = 0xFFFF0000;
+constexpr Uint32 kOverlayPanelColour = 0xFF000000;
+constexpr Uint32 kOverlayTextColour = 0xFFFFCC00;
+
+}  // namespace
 
 // Custom deleter for SDL_Window
 void SDLWindowDeleter(SDL_Window* window) {
@@ -13,16 +29,27 @@ void SDLRendererDeleter(SDL_Renderer* renderer) {
     SDL_DestroyRenderer(renderer);
 }
 
+// Custom deleter for SDL_Texture
+void SDLTextureDeleter(SDL_Texture* texture) {
+    SDL_DestroyTexture(texture);
+}
+
 Renderer::Renderer(const std::size_t screen_width,
                    const std::size_t screen_height,
-                   const std::size_t grid_width, const std::size_t grid_height)
-    : screen_width(screen_width),
+                   const std::size_t grid_width, const std::size_t grid_height,
+                   Mode mode)
+    : sdl_window(nullptr, SDLWindowDeleter),
+      sdl_renderer(nullptr, SDLRendererDeleter),
+      canvas(nullptr, SDLTextureDeleter),
+      cell_texture(nullptr, SDLTextureDeleter),
+      screen_width(screen_width),
       screen_height(screen_height),
       grid_width(grid_width),
       grid_height(grid_height),
-      sdl_window(nullptr, SDLWindowDeleter),
-      sdl_renderer(nullptr, SDLRendererDeleter) {
-  
+      mode(mode) {
+  SetupViewport();
+  ReserveLayers();
+
   // Initialize SDL
   if (SDL_Init(SDL_INIT_VIDEO) < 0) {
     std::cerr << "SDL could not initialize.\n";
@@ -60,12 +87,18 @@ Renderer::~Renderer() {
 
 // Copy Constructor
 Renderer::Renderer(const Renderer& other)
-    : screen_width(other.screen_width),
+    : sdl_window(nullptr, SDLWindowDeleter),
+      sdl_renderer(nullptr, SDLRendererDeleter),
+      canvas(nullptr, SDLTextureDeleter),
+      cell_texture(nullptr, SDLTextureDeleter),
+      screen_width(other.screen_width),
       screen_height(other.screen_height),
       grid_width(other.grid_width),
       grid_height(other.grid_height),
-      sdl_window(nullptr, SDLWindowDeleter),
-      sdl_renderer(nullptr, SDLRendererDeleter) {
+      mode(other.mode) {
+  SetupViewport();
+  ReserveLayers();
+
   // Initialize SDL
   std::cout << "Copy Operator called\n";
   if (SDL_Init(SDL_INIT_VIDEO) < 0) {
@@ -102,6 +135,9 @@ Renderer& Renderer::operator=(const Renderer& other) {
   if (this == &other) return *this;  // Self-assignment check
 
   // Clean up existing resources
+  canvas.reset();
+  cell_texture.reset();
+  texels.clear();
   if (sdl_renderer) SDL_DestroyRenderer(sdl_renderer.release());
   if (sdl_window) SDL_DestroyWindow(sdl_window.release());
 
@@ -110,6 +146,10 @@ Renderer& Renderer::operator=(const Renderer& other) {
   screen_height = other.screen_height;
   grid_width = other.grid_width;
   grid_height = other.grid_height;
+  mode = other.mode;
+  repaint_all = true;
+  SetupViewport();
+  ReserveLayers();
 
   // Reinitialize SDL
   if (SDL_Init(SDL_INIT_VIDEO) < 0) {
@@ -144,12 +184,33 @@ Renderer& Renderer::operator=(const Renderer& other) {
 
 // Move Constructor
 Renderer::Renderer(Renderer&& other) noexcept
-    : screen_width(other.screen_width),
+    : sdl_window(std::move(other.sdl_window)),
+      sdl_renderer(std::move(other.sdl_renderer)),
+      canvas(std::move(other.canvas)),
+      cell_texture(std::move(other.cell_texture)),
+      texels(std::move(other.texels)),
+      screen_width(other.screen_width),
       screen_height(other.screen_height),
       grid_width(other.grid_width),
       grid_height(other.grid_height),
-      sdl_window(std::move(other.sdl_window)),
-      sdl_renderer(std::move(other.sdl_renderer)) {
+      mode(other.mode),
+      block_width(other.block_width),
+      block_height(other.block_height),
+      view_columns(other.view_columns),
+      view_rows(other.view_rows),
+      camera(other.camera),
+      drawn_food(other.drawn_food),
+      drawn_bonus_food(other.drawn_bonus_food),
+      drawn_head(other.drawn_head),
+      repaint_all(other.repaint_all),
+      background_rects(std::move(other.background_rects)),
+      food_rects(std::move(other.food_rects)),
+      bonus_rects(std::move(other.bonus_rects)),
+      body_rects(std::move(other.body_rects)),
+      head_rects(std::move(other.head_rects)),
+      present_duration(other.present_duration),
+      overlay_text(other.overlay_text),
+      overlay_rects(std::move(other.overlay_rects)) {
   // Nullify the other object's pointers
   std::cout << "Move Constructor called\n";
   other.sdl_window = nullptr;
@@ -161,6 +222,9 @@ Renderer& Renderer::operator=(Renderer&& other) noexcept {
   std::cout << "Move Assignment called\n";
   if (this == &other) return *this;  // Self-assignment check
 
+  canvas = std::move(other.canvas);  // Release the old textures while their renderer still exists
+  cell_texture = std::move(other.cell_texture);
+  texels = std::move(other.texels);
   sdl_window = std::move(other.sdl_window);
   sdl_renderer = std::move(other.sdl_renderer);
 
@@ -168,68 +232,431 @@ Renderer& Renderer::operator=(Renderer&& other) noexcept {
   screen_height = other.screen_height;
   grid_width = other.grid_width;
   grid_height = other.grid_height;
+  mode = other.mode;
+  block_width = other.block_width;
+  block_height = other.block_height;
+  view_columns = other.view_columns;
+  view_rows = other.view_rows;
+  camera = other.camera;
+
+  drawn_food = other.drawn_food;
+  drawn_bonus_food = other.drawn_bonus_food;
+  drawn_head = other.drawn_head;
+  repaint_all = other.repaint_all;
+
+  background_rects = std::move(other.background_rects);
+  food_rects = std::move(other.food_rects);
+  bonus_rects = std::move(other.bonus_rects);
+  body_rects = std::move(other.body_rects);
+  head_rects = std::move(other.head_rects);
+  present_duration = other.present_duration;
+  overlay_text = other.overlay_text;
+  overlay_rects = std::move(other.overlay_rects);
 
   return *this;
 }
 
-void Renderer::Render(Snake const snake, SDL_Point const &food, SDL_Point const &bonus_food, int &bonus_food_remaining_time) {
-  SDL_Rect block;
-  block.w = screen_width / grid_width;
-  block.h = screen_height / grid_height;
+void Renderer::Render(Snake const &snake, SDL_Point const &food, SDL_Point const &bonus_food, int &bonus_food_remaining_time,
+                      std::vector<SDL_Point> const &dirty_cells, float alpha) {
+  TRACE_SCOPE("Renderer::Render");
+  SDL_Point head = snake.InterpolateHeadCell(alpha);
+  bool bonus_visible = BonusVisible(bonus_food, bonus_food_remaining_time);
+  CreateTargets();
+  UpdateCamera(snake.GetHeadCell());
+
+  if (mode == Mode::kIncremental) {
+    RenderIncremental(snake, food, bonus_food, bonus_visible, head, dirty_cells);
+  } else if (mode == Mode::kTexture) {
+    RenderTexture(snake, food, bonus_food, bonus_visible, head, dirty_cells);
+  } else {
+    RenderFull(snake, food, bonus_food, bonus_visible, head);
+  }
+}
+
+// A snapshot carries no changed cells, so every frame is drawn in full: the
+// texture mode rewrites the whole viewport, the other modes fill rects. The
+// snapshot holds only the body cells inside GetView(frame.head), the view
+// UpdateCamera picks, so the work is bounded by the viewport.
+void Renderer::Render(FrameSnapshot const &frame, float alpha) {
+  TRACE_SCOPE("Renderer::Render");
+  SDL_Point head = frame.InterpolateHeadCell(alpha);
+  bool bonus_visible = BonusVisible(frame.bonus_food, frame.bonus_food_remaining_time);
+  CreateTargets();
+  UpdateCamera(frame.head);
+
+  ClearLayers();
+  if (frame.food.x != -1 && frame.food.y != -1) AddBlock(food_rects, frame.food.x, frame.food.y);
+  if (bonus_visible) AddBlock(bonus_rects, frame.bonus_food.x, frame.bonus_food.y);
+  for (SDL_Point const &point : frame.body) {
+    if (point.x != head.x || point.y != head.y) AddBlock(body_rects, point.x, point.y);
+  }
+  AddBlock(head_rects, head.x, head.y);
+
+  if (mode == Mode::kTexture) {
+    ShowTexture(frame.alive, true);
+  } else {
+    ShowLayers(frame.alive);
+  }
+  repaint_all = true; // The incremental canvas was not kept up to date
+}
+
+// Bonus food blinks during its last seconds
+bool Renderer::BonusVisible(SDL_Point const &bonus_food, int bonus_food_remaining_time) const {
+  int blinkInterval = 200;
+  return bonus_food.x != -1 && bonus_food.y != -1 && // Ensure bonus food is active
+         (bonus_food_remaining_time >= 4 || SDL_GetTicks() / blinkInterval % 2 == 0);
+}
+
+void Renderer::CreateTargets() {
+  if (mode == Mode::kIncremental && !canvas) {
+    // Create the persistent board the first time it is needed
+    canvas.reset(SDL_CreateTexture(sdl_renderer.get(), SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                                   screen_width, screen_height));
+    if (canvas == nullptr) {
+      std::cerr << "Canvas texture could not be created, falling back to full rendering.\n";
+      std::cerr << "SDL_Error: " << SDL_GetError() << "\n";
+      mode = Mode::kFull;
+    }
+    repaint_all = true;
+  }
+  if (mode == Mode::kTexture && !cell_texture) {
+    // Nearest filtering keeps the cells sharp-edged when the texture is scaled
+    // up; the hint is read when the texture is created
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+    cell_texture.reset(SDL_CreateTexture(sdl_renderer.get(), SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                         view_columns, view_rows));
+    if (cell_texture == nullptr) {
+      std::cerr << "Cell texture could not be created, falling back to full rendering.\n";
+      std::cerr << "SDL_Error: " << SDL_GetError() << "\n";
+      mode = Mode::kFull;
+    }
+    texels.assign(static_cast<std::size_t>(view_columns) * view_rows, kBackgroundColour);
+    repaint_all = true;
+  }
+}
+
+void Renderer::RenderFull(Snake const &snake, SDL_Point const &food, SDL_Point const &bonus_food, bool bonus_visible,
+                          SDL_Point const &head) {
+  CollectAll(snake, food, bonus_food, bonus_visible, head);
+  ShowLayers(snake.IsAlive());
+}
 
+void Renderer::ShowLayers(bool alive) {
   // Clear screen
-  SDL_SetRenderDrawColor(sdl_renderer.get(), 0x1E, 0x1E, 0x1E, 0xFF);
+  SetDrawColour(kBackgroundColour);
+  SDL_RenderClear(sdl_renderer.get());
+
+  DrawLayers(alive);
+  DrawOverlay();
+
+  // Update Screen
+  Present();
+}
+
+void Renderer::RenderIncremental(Snake const &snake, SDL_Point const &food, SDL_Point const &bonus_food,
+                                 bool bonus_visible, SDL_Point const &head,
+                                 std::vector<SDL_Point> const &dirty_cells) {
+  SDL_SetRenderTarget(sdl_renderer.get(), canvas.get());
+  if (CollectChanges(snake, food, bonus_food, bonus_visible, head, dirty_cells)) {
+    SetDrawColour(kBackgroundColour);
+    SDL_RenderClear(sdl_renderer.get());
+  }
+  DrawLayers(snake.IsAlive());
+  SDL_SetRenderTarget(sdl_renderer.get(), nullptr);
+
+  // Blit the board once and update screen
+  SDL_RenderCopy(sdl_renderer.get(), canvas.get(), nullptr, nullptr);
+  DrawOverlay(); // Drawn on the screen, not the canvas, so it never sticks to the board
+  Present();
+}
+
+// The shadow texels mirror the texture, so a changed cell costs one texel
+// write and a frame one upload of the box around its changed texels; the copy
+// to the window is one scaled blit whatever the board size or snake length
+void Renderer::RenderTexture(Snake const &snake, SDL_Point const &food, SDL_Point const &bonus_food,
+                             bool bonus_visible, SDL_Point const &head, std::vector<SDL_Point> const &dirty_cells) {
+  bool repaint = CollectChanges(snake, food, bonus_food, bonus_visible, head, dirty_cells);
+  ShowTexture(snake.IsAlive(), repaint);
+}
+
+void Renderer::ShowTexture(bool alive, bool repaint) {
+  if (repaint) std::fill(texels.begin(), texels.end(), kBackgroundColour);
+  SDL_Rect changed{0, 0, 0, 0};
+  PaintLayer(background_rects, kBackgroundColour, changed);
+  PaintLayer(food_rects, kFoodColour, changed);
+  PaintLayer(bonus_rects, kBonusFoodColour, changed);
+  PaintLayer(body_rects, kBodyColour, changed);
+  PaintLayer(head_rects, alive ? kHeadColour : kDeadHeadColour, changed);
+  int const pitch = view_columns * static_cast<int>(sizeof(Uint32));
+  if (repaint) {
+    SDL_UpdateTexture(cell_texture.get(), nullptr, texels.data(), pitch);
+  } else if (changed.w > 0) {
+    Uint32 const *first = &texels[static_cast<std::size_t>(changed.y) * view_columns + changed.x];
+    SDL_UpdateTexture(cell_texture.get(), &changed, first, pitch);
+  }
+
+  // The window can be wider than the board it shows by less than a cell
+  SetDrawColour(kBackgroundColour);
   SDL_RenderClear(sdl_renderer.get());
+  SDL_Rect board{0, 0, view_columns * block_width, view_rows * block_height};
+  SDL_RenderCopy(sdl_renderer.get(), cell_texture.get(), nullptr, &board);
+  DrawOverlay();
+  Present();
+}
 
-  // Render food
-  SDL_SetRenderDrawColor(sdl_renderer.get(), 0xFF, 0xCC, 0x00, 0xFF);
-  block.x = food.x * block.w;
-  block.y = food.y * block.h;
-  SDL_RenderFillRect(sdl_renderer.get(), &block);
-
-  // Render bonus food
-  if (bonus_food.x != -1 && bonus_food.y != -1) { // Ensure bonus food is active
-    // Determine blinking effect
-    int blinkInterval = 200;
-    if (bonus_food_remaining_time < 4) {
-         if (SDL_GetTicks() / blinkInterval % 2 == 0) {
-            SDL_SetRenderDrawColor(sdl_renderer.get(), 0x00, 0xFF, 0x00, 0xFF); // Green color for bonus food
-            block.x = bonus_food.x * block.w;
-            block.y = bonus_food.y * block.h;
-            SDL_RenderFillRect(sdl_renderer.get(), &block); 
-          }
+bool Renderer::CollectChanges(Snake const &snake, SDL_Point const &food, SDL_Point const &bonus_food,
+                              bool bonus_visible, SDL_Point const &head, std::vector<SDL_Point> const &dirty_cells) {
+  bool repaint = repaint_all;
+  if (repaint_all) {
+    CollectAll(snake, food, bonus_food, bonus_visible, head);
+    repaint_all = false;
+  } else {
+    ClearLayers();
+    for (SDL_Point const &cell : dirty_cells) {
+      CollectCell(snake, food, bonus_food, bonus_visible, head, cell);
     }
-    else {
-            SDL_SetRenderDrawColor(sdl_renderer.get(), 0x00, 0xFF, 0x00, 0xFF); // Green color for bonus food
-            block.x = bonus_food.x * block.w;
-            block.y = bonus_food.y * block.h;
-            SDL_RenderFillRect(sdl_renderer.get(), &block); 
+    // Food, bonus food and head may have moved or blinked without the game
+    // reporting it; repainting their old and new cells is constant work.
+    for (SDL_Point const &cell : {drawn_food, drawn_bonus_food, drawn_head, food, bonus_food, head}) {
+      if (cell.x != -1 && cell.y != -1) CollectCell(snake, food, bonus_food, bonus_visible, head, cell);
     }
   }
 
-  // Render snake's body
-  SDL_SetRenderDrawColor(sdl_renderer.get(), 0xFF, 0xFF, 0xFF, 0xFF);
-  for (SDL_Point const &point : snake.GetBody()) {
-    block.x = point.x * block.w;
-    block.y = point.y * block.h;
-    SDL_RenderFillRect(sdl_renderer.get(), &block);
+  drawn_food = food;
+  drawn_bonus_food = bonus_food;
+  drawn_head = head;
+  return repaint;
+}
+
+void Renderer::CollectAll(Snake const &snake, SDL_Point const &food, SDL_Point const &bonus_food, bool bonus_visible,
+                          SDL_Point const &head) {
+  ClearLayers();
+
+  // Food layer
+  if (food.x != -1 && food.y != -1) { // No food is left once the board is full
+    AddBlock(food_rects, food.x, food.y);
   }
 
-  // Render snake's head
-  block.x = static_cast<int>(snake.GetHeadX()) * block.w;
-  block.y = static_cast<int>(snake.GetHeadY()) * block.h;
-  if (snake.IsAlive()) {
-    SDL_SetRenderDrawColor(sdl_renderer.get(), 0x00, 0x7A, 0xCC, 0xFF);
+  // Bonus food layer
+  if (bonus_visible) {
+    AddBlock(bonus_rects, bonus_food.x, bonus_food.y);
+  }
+
+  // Snake's body layer
+  if (view_columns == static_cast<int>(grid_width) && view_rows == static_cast<int>(grid_height)) {
+    // The drawn head may still be in a body cell; the head's current cell is
+    // not in the body and is left empty until the drawn head reaches it
+    for (SDL_Point const &point : snake.GetBody()) {
+      if (point.x != head.x || point.y != head.y) AddBlock(body_rects, point.x, point.y);
+    }
   } else {
-    SDL_SetRenderDrawColor(sdl_renderer.get(), 0xFF, 0x00, 0x00, 0xFF);
+    CollectVisibleBody(snake, head);
   }
-  SDL_RenderFillRect(sdl_renderer.get(), &block);
 
-  // Update Screen
-  SDL_RenderPresent(sdl_renderer.get());
+  // Snake's head layer
+  AddBlock(head_rects, head.x, head.y);
+}
+
+// Walking the occupancy grid instead of the body keeps the cost bounded by
+// the viewport however long the snake is. Every occupied cell but the drawn
+// head and the head's current cell, which it has not reached yet, is body.
+void Renderer::CollectVisibleBody(Snake const &snake, SDL_Point const &head) {
+  SDL_Point current_head = snake.GetHeadCell();
+  snake.GetOccupancy().ForEachOccupied(SDL_Rect{camera.x, camera.y, view_columns, view_rows}, [&](int x, int y) {
+    if ((x != head.x || y != head.y) && (x != current_head.x || y != current_head.y)) AddBlock(body_rects, x, y);
+  });
+}
+
+void Renderer::CollectCell(Snake const &snake, SDL_Point const &food, SDL_Point const &bonus_food, bool bonus_visible,
+                           SDL_Point const &head, SDL_Point const &cell) {
+  SDL_Point current_head = snake.GetHeadCell();
+  if (cell.x == head.x && cell.y == head.y) {
+    AddBlock(head_rects, cell.x, cell.y);
+  } else if (snake.SnakeCell(cell.x, cell.y) && (cell.x != current_head.x || cell.y != current_head.y)) {
+    AddBlock(body_rects, cell.x, cell.y);
+  } else if (bonus_visible && cell.x == bonus_food.x && cell.y == bonus_food.y) {
+    AddBlock(bonus_rects, cell.x, cell.y);
+  } else if (cell.x == food.x && cell.y == food.y) {
+    AddBlock(food_rects, cell.x, cell.y);
+  } else {
+    AddBlock(background_rects, cell.x, cell.y);
+  }
+}
+
+// One draw call per layer, independent of the snake's length
+void Renderer::DrawLayers(bool alive) {
+  DrawLayer(background_rects, kBackgroundColour);
+  DrawLayer(food_rects, kFoodColour);
+  DrawLayer(bonus_rects, kBonusFoodColour);
+  DrawLayer(body_rects, kBodyColour);
+  DrawLayer(head_rects, alive ? kHeadColour : kDeadHeadColour);
+}
+
+// Empty the colour layers; their capacity is kept across frames
+void Renderer::ClearLayers() {
+  background_rects.clear();
+  food_rects.clear();
+  bonus_rects.clear();
+  body_rects.clear();
+  head_rects.clear();
 }
 
 void Renderer::UpdateWindowTitle(int score, int fps) {
   std::string title{"Snake Score: " + std::to_string(score) + " FPS: " + std::to_string(fps)};
   SDL_SetWindowTitle(sdl_window.get(), title.c_str());
 }
+
+// Kept apart so the trace shows how long the frame waits on the display
+void Renderer::Present() {
+  TRACE_SCOPE("SDL_RenderPresent");
+  auto start = std::chrono::steady_clock::now();
+  SDL_RenderPresent(sdl_renderer.get());
+  present_duration = std::chrono::steady_clock::now() - start;
+}
+
+bool Renderer::HasVsync() const {
+  SDL_RendererInfo info;
+  if (sdl_renderer == nullptr || SDL_GetRendererInfo(sdl_renderer.get(), &info) != 0) return false;
+  return (info.flags & SDL_RENDERER_PRESENTVSYNC) != 0;
+}
+
+void Renderer::SetOverlayText(char const *text) {
+  overlay_text[0] = '\0';
+  if (text == nullptr) return;
+  std::size_t length = std::min(std::strlen(text), overlay_text.size() - 1);
+  std::copy(text, text + length, overlay_text.begin());
+  overlay_text[length] = '\0';
+}
+
+namespace {
+
+// 3x5 pixel glyphs, five rows of three bits from the top, leftmost pixel in
+// the highest bit of each row; 0 for characters without a glyph
+std::uint16_t OverlayGlyph(char c) {
+  static std::uint16_t const kDigits[10] = {
+      0b111'101'101'101'111, 0b010'110'010'010'111, 0b111'001'111'100'111, 0b111'001'111'001'111,
+      0b101'101'111'001'001, 0b111'100'111'001'111, 0b111'100'111'101'111, 0b111'001'001'001'001,
+      0b111'101'111'101'111, 0b111'101'111'001'111};
+  if (c >= '0' && c <= '9') return kDigits[c - '0'];
+  switch (c) {
+    case 'F': return 0b111'100'110'100'100;
+    case 'I': return 0b111'010'010'010'111;
+    case 'R': return 0b110'101'110'101'101;
+    case 'U': return 0b101'101'101'101'111;
+    default: return 0;
+  }
+}
+
+}  // namespace
+
+// Every lit font pixel is one rect, drawn with a single fill call over a
+// dark panel sized to the text
+void Renderer::DrawOverlay() {
+  if (overlay_text[0] == '\0') return;
+  constexpr int kScale = 3; // Screen pixels per font pixel
+  constexpr int kMargin = 2 * kScale;
+  constexpr int kAdvance = 4 * kScale; // Glyph width plus spacing
+  constexpr int kLineHeight = 6 * kScale;
+
+  overlay_rects.clear();
+  int column = 0;
+  int columns = 0;
+  int line = 0;
+  for (char const *c = overlay_text.data(); *c != '\0'; ++c) {
+    if (*c == '\n') {
+      line++;
+      column = 0;
+      continue;
+    }
+    std::uint16_t glyph = OverlayGlyph(*c);
+    int left = kMargin + column * kAdvance;
+    int top = kMargin + line * kLineHeight;
+    for (int bit = 0; bit < 15; ++bit) {
+      if (glyph & (1 << (14 - bit))) {
+        overlay_rects.push_back(SDL_Rect{left + bit % 3 * kScale, top + bit / 3 * kScale, kScale, kScale});
+      }
+    }
+    column++;
+    columns = std::max(columns, column);
+  }
+  int lines = column > 0 ? line + 1 : line;
+
+  SDL_Rect panel{0, 0, 2 * kMargin + columns * kAdvance - kScale, 2 * kMargin + lines * kLineHeight - kScale};
+  SetDrawColour(kOverlayPanelColour);
+  SDL_RenderFillRect(sdl_renderer.get(), &panel);
+  DrawLayer(overlay_rects, kOverlayTextColour);
+}
+
+void Renderer::ReserveLayers() {
+  // The incremental mode repaints a handful of cells per tick, but several
+  // ticks can pass between frames, so background and food layers get room
+  // for a few dozen cells.
+  background_rects.reserve(64);
+  food_rects.reserve(8);
+  bonus_rects.reserve(8);
+  body_rects.reserve(static_cast<std::size_t>(view_columns) * view_rows);
+  head_rects.reserve(8);
+  overlay_rects.reserve(overlay_text.size() * 15 + 1);
+}
+
+// Cells are as large as the window allows, but never smaller than
+// kMinBlockSize; a partly visible last row or column still counts as visible
+void Renderer::SetupViewport() {
+  block_width = std::max(kMinBlockSize, static_cast<int>(screen_width / grid_width));
+  block_height = std::max(kMinBlockSize, static_cast<int>(screen_height / grid_height));
+  view_columns = std::min(static_cast<int>(grid_width),
+                          (static_cast<int>(screen_width) + block_width - 1) / block_width);
+  view_rows = std::min(static_cast<int>(grid_height),
+                       (static_cast<int>(screen_height) + block_height - 1) / block_height);
+  camera = SDL_Point{0, 0};
+}
+
+SDL_Rect Renderer::GetView(SDL_Point const &head) const {
+  return SDL_Rect{std::max(0, std::min(head.x - view_columns / 2, static_cast<int>(grid_width) - view_columns)),
+                  std::max(0, std::min(head.y - view_rows / 2, static_cast<int>(grid_height) - view_rows)),
+                  view_columns, view_rows};
+}
+
+void Renderer::UpdateCamera(SDL_Point const &head) {
+  SDL_Rect view = GetView(head);
+  SDL_Point target{view.x, view.y};
+  if (target.x != camera.x || target.y != camera.y) {
+    camera = target;
+    repaint_all = true; // Every cell of the canvas now shows a different board cell
+  }
+}
+
+void Renderer::AddBlock(std::vector<SDL_Rect> &layer, int x, int y) const {
+  if (!Visible(x, y)) return;
+  layer.push_back(SDL_Rect{(x - camera.x) * block_width, (y - camera.y) * block_height, block_width, block_height});
+}
+
+void Renderer::DrawLayer(std::vector<SDL_Rect> const &layer, Uint32 colour) {
+  if (layer.empty()) return;
+  SetDrawColour(colour);
+  SDL_RenderFillRects(sdl_renderer.get(), layer.data(), static_cast<int>(layer.size()));
+}
+
+// Layer rects are in screen pixels; each one covers exactly one visible cell
+void Renderer::PaintLayer(std::vector<SDL_Rect> const &layer, Uint32 colour, SDL_Rect &changed) {
+  for (SDL_Rect const &rect : layer) {
+    int x = rect.x / block_width;
+    int y = rect.y / block_height;
+    texels[static_cast<std::size_t>(y) * view_columns + x] = colour;
+    if (changed.w == 0) {
+      changed = SDL_Rect{x, y, 1, 1};
+      continue;
+    }
+    int right = std::max(changed.x + changed.w, x + 1);
+    int bottom = std::max(changed.y + changed.h, y + 1);
+    changed.x = std::min(changed.x, x);
+    changed.y = std::min(changed.y, y);
+    changed.w = right - changed.x;
+    changed.h = bottom - changed.y;
+  }
+}
+
+void Renderer::SetDrawColour(Uint32 colour) {
+  SDL_SetRenderDrawColor(sdl_renderer.get(), (colour >> 16) & 0xFF, (colour >> 8) & 0xFF, colour & 0xFF,
+                         colour >> 24);
+}
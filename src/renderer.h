@@ -1,15 +1,29 @@
 #ifndef RENDERER_H
 #define RENDERER_H
 
+#include <array>
+#include <chrono>
 #include <vector>
 #include "SDL.h"
 #include "snake.h"
 #include <memory>
+#include "frame_snapshot.h"
 
 class Renderer {
 public:
+    // kFull redraws every cell each frame. kIncremental keeps the board in a
+    // persistent target texture and only repaints the cells that changed.
+    // kTexture keeps one texel per visible cell in a streaming texture,
+    // rewrites only the changed texels and scales it to the window in one copy.
+    enum class Mode { kFull, kIncremental, kTexture };
+
+    // Smallest cell size in pixels. A board with more cells than fit at this
+    // size is shown through a camera that follows the snake's head.
+    static constexpr int kMinBlockSize = 4;
+
     Renderer(const std::size_t screen_width, const std::size_t screen_height,
-             const std::size_t grid_width, const std::size_t grid_height);
+             const std::size_t grid_width, const std::size_t grid_height,
+             Mode mode = Mode::kFull);
     ~Renderer();
 
     Renderer(const Renderer& other);  // Copy constructor
@@ -17,16 +31,126 @@ public:
     Renderer(Renderer&& other) noexcept;  // Move constructor
     Renderer& operator=(Renderer&& other) noexcept;  // Move assignment operator
 
-    void Render(Snake const snake, SDL_Point const &food, SDL_Point const&bonus_food, int &bonus_food_remaining_time);
+    // dirty_cells lists the cells changed by the simulation since the last call;
+    // only the incremental mode reads it. alpha is the fraction of the next
+    // simulation tick already elapsed; the head is drawn that far between its
+    // positions before and after the last tick, and the cell it has not
+    // reached yet is left as it was.
+    void Render(Snake const &snake, SDL_Point const &food, SDL_Point const&bonus_food, int &bonus_food_remaining_time,
+                std::vector<SDL_Point> const &dirty_cells, float alpha);
+    // Draws a snapshot published by the simulation thread; alpha places the
+    // drawn head as above. Every frame is drawn in full.
+    void Render(FrameSnapshot const &frame, float alpha);
     void UpdateWindowTitle(int score, int fps);
+    // How long the last SDL_RenderPresent call blocked
+    std::chrono::steady_clock::duration GetPresentDuration() const { return present_duration; }
+    // True if the renderer reports that presents wait for vsync
+    bool HasVsync() const;
+    // Text drawn in the top-left corner of every frame until replaced, one
+    // line per '\n'; digits, spaces and the letters F, I, R and U are drawn,
+    // other characters are skipped. nullptr or "" hides the overlay.
+    void SetOverlayText(char const *text);
+    // The cells visible while the camera follows head. Reads only sizes fixed
+    // at construction, so the simulation thread may call it while this one renders.
+    SDL_Rect GetView(SDL_Point const &head) const;
 
 private:
+    // Returns true if the bonus food is on the board and not blinked out
+    bool BonusVisible(SDL_Point const &bonus_food, int bonus_food_remaining_time) const;
+    // Creates the canvas or the cell texture the first time the mode needs it
+    void CreateTargets();
+    // Redraws the whole board to the screen
+    void RenderFull(Snake const &snake, SDL_Point const &food, SDL_Point const &bonus_food, bool bonus_visible,
+                    SDL_Point const &head);
+    // Repaints the changed cells into the canvas texture, then copies it to the screen
+    void RenderIncremental(Snake const &snake, SDL_Point const &food, SDL_Point const &bonus_food, bool bonus_visible,
+                           SDL_Point const &head, std::vector<SDL_Point> const &dirty_cells);
+    // Writes the changed cells into the cell texture, then scales it to the screen
+    void RenderTexture(Snake const &snake, SDL_Point const &food, SDL_Point const &bonus_food, bool bonus_visible,
+                       SDL_Point const &head, std::vector<SDL_Point> const &dirty_cells);
+    // Clears the screen, draws the layers and the overlay, and presents
+    void ShowLayers(bool alive);
+    // Paints the layers into the cell texture, uploading every texel after a
+    // repaint or otherwise the box around the painted ones in a single call,
+    // then blits it and presents
+    void ShowTexture(bool alive, bool repaint);
+    // Fills the colour layers with the cells to repaint since the last frame:
+    // every cell after repaint_all, otherwise the dirty cells plus the old and
+    // new food, bonus food and head. Returns true for a full repaint.
+    bool CollectChanges(Snake const &snake, SDL_Point const &food, SDL_Point const &bonus_food, bool bonus_visible,
+                        SDL_Point const &head, std::vector<SDL_Point> const &dirty_cells);
+    // Fills the colour layers with every object on the board
+    void CollectAll(Snake const &snake, SDL_Point const &food, SDL_Point const &bonus_food, bool bonus_visible,
+                    SDL_Point const &head);
+    // Appends one cell to the layer of whatever currently occupies it
+    void CollectCell(Snake const &snake, SDL_Point const &food, SDL_Point const &bonus_food, bool bonus_visible,
+                     SDL_Point const &head, SDL_Point const &cell);
+    // Draws every layer, background first
+    void DrawLayers(bool alive);
+    void ClearLayers();
+
+    // Preallocates the rect buffers so that filling them never reallocates
+    void ReserveLayers();
+    // Derives the cell size and the number of visible cells from the screen and grid sizes
+    void SetupViewport();
+    // Centres the camera on the head, clamped to the board; a move repaints the canvas
+    void UpdateCamera(SDL_Point const &head);
+    // Adds every visible body cell to the body layer, visiting only the
+    // occupancy chunks that overlap the viewport and hold segments
+    void CollectVisibleBody(Snake const &snake, SDL_Point const &head);
+    // True if grid cell (x, y) lies inside the viewport
+    bool Visible(int x, int y) const {
+        return x >= camera.x && x < camera.x + view_columns && y >= camera.y && y < camera.y + view_rows;
+    }
+    // Appends the screen rect of grid cell (x, y) to a layer if the cell is visible
+    void AddBlock(std::vector<SDL_Rect> &layer, int x, int y) const;
+    // Draws a whole layer in one colour with a single SDL_RenderFillRects call
+    void DrawLayer(std::vector<SDL_Rect> const &layer, Uint32 colour);
+    // Writes a layer into the shadow texels and grows changed, in texels, to cover them
+    void PaintLayer(std::vector<SDL_Rect> const &layer, Uint32 colour, SDL_Rect &changed);
+    // Sets the draw colour from a 0xAARRGGBB value
+    void SetDrawColour(Uint32 colour);
+    // Draws the overlay text over the board with a built-in 3x5 pixel font
+    void DrawOverlay();
+    // Shows the finished frame
+    void Present();
+
     std::unique_ptr<SDL_Window, void(*)(SDL_Window*)> sdl_window;
     std::unique_ptr<SDL_Renderer, void(*)(SDL_Renderer*)> sdl_renderer;
+    std::unique_ptr<SDL_Texture, void(*)(SDL_Texture*)> canvas; // Persistent board for the incremental mode
+    std::unique_ptr<SDL_Texture, void(*)(SDL_Texture*)> cell_texture; // One texel per visible cell for the texture mode
+    std::vector<Uint32> texels; // Shadow copy of cell_texture, row by row
     std::size_t screen_width;
     std::size_t screen_height;
     std::size_t grid_width;
     std::size_t grid_height;
+    Mode mode;
+
+    int block_width{1}; // Cell size in pixels
+    int block_height{1};
+    int view_columns{1}; // Cells visible on screen
+    int view_rows{1};
+    SDL_Point camera{0, 0}; // Top-left visible cell
+
+    // Cells drawn with food, bonus food and head in the previous frame. The
+    // incremental mode always repaints them, so expiring or blinking bonus
+    // food needs no extra bookkeeping from the game.
+    SDL_Point drawn_food{-1, -1};
+    SDL_Point drawn_bonus_food{-1, -1};
+    SDL_Point drawn_head{-1, -1};
+    bool repaint_all{true}; // The canvas has to be redrawn from scratch
+
+    // One reusable rect buffer per colour layer, refilled every frame
+    std::vector<SDL_Rect> background_rects;
+    std::vector<SDL_Rect> food_rects;
+    std::vector<SDL_Rect> bonus_rects;
+    std::vector<SDL_Rect> body_rects;
+    std::vector<SDL_Rect> head_rects;
+
+    std::chrono::steady_clock::duration present_duration{0}; // Time spent in the last present
+
+    std::array<char, 256> overlay_text{}; // Empty when the overlay is hidden
+    std::vector<SDL_Rect> overlay_rects; // Pixels of the overlay text
 };
 
 #endif
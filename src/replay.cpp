@@ -0,0 +1,180 @@
+#include "replay.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include "game.h"
+
+namespace {
+
+constexpr char kMagic[4] = {'S', 'N', 'K', 'R'};
+// Version 2: fixed-point snake movement, sessions recorded before it no longer replay identically
+// Version 3: records the initial speed and the speed step
+constexpr std::uint8_t kVersion = 3;
+constexpr std::uint8_t kFirstFixedPointVersion = 2;
+
+void WriteInt(std::ostream &out, std::uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i) {
+    out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+void WriteVarint(std::ostream &out, std::uint64_t value) {
+  while (value >= 0x80) {
+    out.put(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.put(static_cast<char>(value));
+}
+
+// Sequential reader over the loaded file; any read past the end marks it failed
+class Reader {
+ public:
+  explicit Reader(std::vector<char> const &data) : data(data) {}
+
+  std::uint64_t Int(int bytes) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) value |= static_cast<std::uint64_t>(Byte()) << (8 * i);
+    return value;
+  }
+
+  std::uint64_t Varint() {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      std::uint8_t byte = Byte();
+      value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) return value;
+    }
+    failed = true;
+    return value;
+  }
+
+  std::uint8_t Byte() {
+    if (position >= data.size()) {
+      failed = true;
+      return 0;
+    }
+    return static_cast<std::uint8_t>(data[position++]);
+  }
+
+  bool Failed() const { return failed; }
+
+ private:
+  std::vector<char> const &data;
+  std::size_t position{0};
+  bool failed{false};
+};
+
+}  // namespace
+
+// Constructor
+// A new snake always starts moving up, so only later changes are logged
+InputRecorder::InputRecorder(std::uint32_t seed, Config const &config)
+  : seed(seed),
+    grid_width(static_cast<int>(config.grid_width)),
+    grid_height(static_cast<int>(config.grid_height)),
+    ticks_per_second(config.ticks_per_second),
+    initial_speed(Snake::ToFixed(config.initial_speed)),
+    speed_step(Snake::ToFixed(config.speed_step)),
+    last_direction(Snake::Direction::kUp) {}
+
+void InputRecorder::Record(std::uint64_t tick, Snake::Direction direction) {
+  if (direction == last_direction) return;
+  events.push_back(InputEvent{tick, direction});
+  last_direction = direction;
+}
+
+bool InputRecorder::Save(std::string const &file_name, std::uint64_t total_ticks, int score,
+                         int size) const {
+  std::ofstream file(file_name, std::ios::binary);
+  if (!file.is_open()) return false;
+
+  file.write(kMagic, sizeof(kMagic));
+  WriteInt(file, kVersion, 1);
+  WriteInt(file, seed, 4);
+  WriteInt(file, static_cast<std::uint32_t>(grid_width), 4);
+  WriteInt(file, static_cast<std::uint32_t>(grid_height), 4);
+  WriteInt(file, static_cast<std::uint32_t>(ticks_per_second), 4);
+  WriteInt(file, static_cast<std::uint32_t>(initial_speed), 4);
+  WriteInt(file, static_cast<std::uint32_t>(speed_step), 4);
+  WriteInt(file, total_ticks, 8);
+  WriteInt(file, static_cast<std::uint32_t>(score), 4);
+  WriteInt(file, static_cast<std::uint32_t>(size), 4);
+  WriteInt(file, static_cast<std::uint32_t>(events.size()), 4);
+
+  std::uint64_t previous_tick = 0;
+  for (InputEvent const &event : events) {
+    WriteVarint(file, event.tick - previous_tick);
+    WriteInt(file, static_cast<std::uint8_t>(event.direction), 1);
+    previous_tick = event.tick;
+  }
+  return static_cast<bool>(file);
+}
+
+bool ReplaySession::Load(std::string const &file_name) {
+  std::ifstream file(file_name, std::ios::binary);
+  if (!file.is_open()) return false;
+  std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  Reader reader(data);
+  for (char expected : kMagic) {
+    if (reader.Byte() != static_cast<std::uint8_t>(expected)) return false;
+  }
+  std::uint64_t version = reader.Int(1);
+  if (version < kFirstFixedPointVersion || version > kVersion) return false;
+  seed = static_cast<std::uint32_t>(reader.Int(4));
+  grid_width = static_cast<int>(reader.Int(4));
+  grid_height = static_cast<int>(reader.Int(4));
+  ticks_per_second = static_cast<std::size_t>(reader.Int(4));
+  initial_speed = Snake::ToFixed(Config{}.initial_speed);
+  speed_step = Snake::ToFixed(Config{}.speed_step);
+  if (version >= 3) {
+    initial_speed = static_cast<std::int32_t>(reader.Int(4));
+    speed_step = static_cast<std::int32_t>(reader.Int(4));
+  }
+  total_ticks = reader.Int(8);
+  recorded_score = static_cast<std::int32_t>(reader.Int(4));
+  recorded_size = static_cast<std::int32_t>(reader.Int(4));
+  std::uint64_t count = reader.Int(4);
+
+  events.clear();
+  std::uint64_t tick = 0;
+  for (std::uint64_t i = 0; i < count && !reader.Failed(); ++i) {
+    tick += reader.Varint();
+    std::uint8_t direction = reader.Byte();
+    if (direction > static_cast<std::uint8_t>(Snake::Direction::kRight)) return false;
+    events.push_back(InputEvent{tick, static_cast<Snake::Direction>(direction)});
+  }
+  return !reader.Failed() && grid_width > 0 && grid_height > 0 && ticks_per_second > 0 && initial_speed > 0 &&
+         initial_speed < (static_cast<std::int64_t>(std::min(grid_width, grid_height)) << Snake::kFixedShift) &&
+         speed_step >= 0;
+}
+
+bool ReplaySession::Run() {
+  // Speeds are stored in fixed point; fractions of 2^16 convert to float and back exactly
+  Config config;
+  config.grid_width = static_cast<std::size_t>(grid_width);
+  config.grid_height = static_cast<std::size_t>(grid_height);
+  config.ticks_per_second = ticks_per_second;
+  config.initial_speed = static_cast<float>(initial_speed) / Snake::kFixedOne;
+  config.speed_step = static_cast<float>(speed_step) / Snake::kFixedOne;
+  Game game(config, seed);
+  auto start = std::chrono::steady_clock::now();
+
+  // Game::Update advances the tick before doing anything else, so the update
+  // for tick t runs right after the events recorded for t are applied.
+  std::size_t next_event = 0;
+  for (std::uint64_t tick = 1; tick <= total_ticks; ++tick) {
+    while (next_event < events.size() && events[next_event].tick == tick) {
+      game.GetSnake().SetDirection(events[next_event].direction);
+      next_event++;
+    }
+    game.Update();
+  }
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  ticks_per_wall_second = seconds > 0 ? total_ticks / seconds : 0.0;
+  score = game.GetScore();
+  size = game.GetSize();
+  return score == recorded_score && size == recorded_size;
+}
@@ -0,0 +1,84 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "snake.h"
+
+// Binary session format, all integers little-endian:
+//   "SNKR", u8 version,
+//   u32 seed, u32 grid width, u32 grid height, u32 ticks per second,
+//   u32 initial speed and u32 speed step in fixed-point cells per tick,
+//   u64 total ticks, i32 final score, i32 final size, u32 event count,
+//   then per event: tick delta to the previous event as a LEB128 varint and
+//   the new direction as one byte.
+// Version 2 files, without the two speeds, replay at the default speeds.
+
+// A direction change that takes effect at the start of a simulation tick
+struct InputEvent {
+  std::uint64_t tick;
+  Snake::Direction direction;
+};
+
+class InputRecorder {
+ public:
+  // Constructor
+  // Remembers the game settings needed to rebuild the session on replay
+  InputRecorder(std::uint32_t seed, Config const &config);
+
+  // Logs the direction in effect for the given tick if it changed since the last call
+  void Record(std::uint64_t tick, Snake::Direction direction);
+
+  // Writes the session and its final state to file
+  // Returns false if the file cannot be written
+  bool Save(std::string const &file_name, std::uint64_t total_ticks, int score, int size) const;
+
+ private:
+  std::uint32_t seed;
+  int grid_width;
+  int grid_height;
+  std::size_t ticks_per_second;
+  std::int32_t initial_speed; // Fixed point
+  std::int32_t speed_step; // Fixed point
+  Snake::Direction last_direction; // Direction the snake starts with until the first change
+  std::vector<InputEvent> events;
+};
+
+class ReplaySession {
+ public:
+  // Reads a session written by InputRecorder::Save
+  // Returns false if the file is missing or malformed
+  bool Load(std::string const &file_name);
+
+  // Re-runs the session headlessly as fast as possible
+  // Returns true if the final score and size match the recorded ones
+  bool Run();
+
+  // Results of the last Run, next to the recorded expectations
+  int GetScore() const { return score; }
+  int GetSize() const { return size; }
+  int GetRecordedScore() const { return recorded_score; }
+  int GetRecordedSize() const { return recorded_size; }
+  std::uint64_t GetTotalTicks() const { return total_ticks; }
+  double GetTicksPerSecond() const { return ticks_per_wall_second; }
+
+ private:
+  std::uint32_t seed{0};
+  int grid_width{0};
+  int grid_height{0};
+  std::size_t ticks_per_second{0};
+  std::int32_t initial_speed{0}; // Fixed point
+  std::int32_t speed_step{0}; // Fixed point
+  std::uint64_t total_ticks{0};
+  int recorded_score{0};
+  int recorded_size{0};
+  std::vector<InputEvent> events;
+
+  int score{0};
+  int size{0};
+  double ticks_per_wall_second{0.0};
+};
+
+#endif
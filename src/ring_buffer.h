@@ -0,0 +1,102 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+// Circular buffer with constant-time push at the back and pop at the front.
+// Storage is allocated in the constructor; PushBack never grows it, so a
+// buffer only reallocates when its owner calls Reserve, which copies every
+// element.
+template <typename T>
+class RingBuffer {
+ public:
+  // Read-only iterator walking the elements from front to back
+  class ConstIterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T const *;
+    using reference = T const &;
+
+    ConstIterator(RingBuffer const *buffer, std::size_t index)
+      : buffer(buffer), index(index) {}
+
+    reference operator*() const { return (*buffer)[index]; }
+    pointer operator->() const { return &(*buffer)[index]; }
+    ConstIterator &operator++() { ++index; return *this; }
+    ConstIterator operator++(int) { ConstIterator copy(*this); ++index; return copy; }
+    bool operator==(ConstIterator const &other) const { return index == other.index; }
+    bool operator!=(ConstIterator const &other) const { return index != other.index; }
+
+   private:
+    RingBuffer const *buffer;
+    std::size_t index; // Logical position counted from the front
+  };
+
+  // Constructor
+  // Allocates room for capacity elements up front
+  explicit RingBuffer(std::size_t capacity) : data(capacity) {}
+
+  // Appends an element at the back
+  // Throws length_error if the buffer is full
+  void PushBack(T const &value) {
+    if (count == data.size()) {
+      throw std::length_error("RingBuffer is full");
+    }
+    data[Wrap(first + count)] = value;
+    ++count;
+  }
+
+  // Removes the element at the front
+  void PopFront() {
+    first = Wrap(first + 1);
+    --count;
+  }
+
+  // Grows the storage to hold at least capacity elements, keeping the
+  // elements and their order; never shrinks
+  void Reserve(std::size_t capacity) {
+    if (capacity <= data.size()) return;
+    std::vector<T> grown(capacity);
+    for (std::size_t i = 0; i < count; ++i) {
+      grown[i] = (*this)[i];
+    }
+    data.swap(grown);
+    first = 0;
+  }
+
+  // Removes every element; the storage is kept
+  void Clear() {
+    first = 0;
+    count = 0;
+  }
+
+  T const &Front() const { return data[first]; }
+  T const &Back() const { return data[Wrap(first + count - 1)]; }
+
+  // Element at the logical position i counted from the front
+  T const &operator[](std::size_t i) const { return data[Wrap(first + i)]; }
+
+  std::size_t Size() const { return count; }
+  bool Empty() const { return count == 0; }
+  std::size_t Capacity() const { return data.size(); }
+
+  ConstIterator begin() const { return ConstIterator(this, 0); }
+  ConstIterator end() const { return ConstIterator(this, count); }
+
+ private:
+  // Maps an index in [0, 2 * capacity) back into the storage
+  std::size_t Wrap(std::size_t i) const {
+    return i >= data.size() ? i - data.size() : i;
+  }
+
+  std::vector<T> data; // Storage, only resized by Reserve
+  std::size_t first{0}; // Storage index of the front element
+  std::size_t count{0}; // Number of stored elements
+};
+
+#endif
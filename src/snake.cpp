@@ -1,33 +1,55 @@
 #include "snake.h"
-#include <cmath>
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include "trace.h"
+
+namespace {
+
+// The initial speed in fixed point, checked before conversion so that a huge
+// value cannot overflow
+std::int32_t InitialSpeed(float cells, int grid_width, int grid_height) {
+  if (!(cells > 0) || cells >= std::min(grid_width, grid_height)) {
+    throw std::invalid_argument("Speed must be positive and less than the grid size");
+  }
+  return std::min(Snake::ToFixed(cells), std::min(grid_width, grid_height) << Snake::kFixedShift);
+}
+
+}  // namespace
 
 // Constructor
 // Initialize the snake at the center of the grid with initial settings
-Snake::Snake(int grid_width, int grid_height)
-  : grid_width(grid_width),
-    grid_height(grid_height),
-    head_x(grid_width/2),
-    head_y(grid_height/2),
-    direction(Direction::kUp),
-    speed(0.1f),
+Snake::Snake(int grid_width, int grid_height, float initial_speed)
+  : direction(Direction::kUp),
+    speed(InitialSpeed(initial_speed, grid_width, grid_height)),
+    initial_speed(speed),
     size(1),
     alive(true),
-    growing(false) {}
+    head_x((grid_width/2) << kFixedShift),
+    head_y((grid_height/2) << kFixedShift),
+    prev_head_x(head_x),
+    prev_head_y(head_y),
+    body(std::min(static_cast<std::size_t>(grid_width) * grid_height, kInitialBodyCapacity)),
+    growing(false),
+    grid_width(grid_width),
+    grid_height(grid_height),
+    occupancy(grid_width, grid_height) {
+  if (speed <= 0) {
+    throw std::invalid_argument("Speed must be positive");
+  }
+  occupancy.Occupy(GetHeadCell().x, GetHeadCell().y);
+  dirty_cells.reserve(16);
+}
 
 // Update the snake's position and checks for collisions
 void Snake::Update() {
   // Capture the current head position before updating
-  SDL_Point prev_cell{
-      static_cast<int>(head_x),
-      static_cast<int>(head_y)};
+  SDL_Point prev_cell = GetHeadCell();
   UpdateHead();
   // Capture the current head position after updating
-  SDL_Point current_cell{
-      static_cast<int>(head_x),
-      static_cast<int>(head_y)};  
+  SDL_Point current_cell = GetHeadCell();
 
-  // Update all of the body vector items if the snake head has moved to a new
+  // Update all of the body items if the snake head has moved to a new
   // cell.
   if (current_cell.x != prev_cell.x || current_cell.y != prev_cell.y) {
     UpdateBody(current_cell, prev_cell);
@@ -36,62 +58,79 @@ void Snake::Update() {
 
 // Update the snake's head position based on its direction
 void Snake::UpdateHead() {
-  switch (direction) {
-    case Direction::kUp:
-      head_y -= speed;
-      break;
-
-    case Direction::kDown:
-      head_y += speed;
-      break;
-
-    case Direction::kLeft:
-      head_x -= speed;
-      break;
-
-    case Direction::kRight:
-      head_x += speed;
-      break;
-  }
+  int d = static_cast<int>(direction);
+  head_x += kDirectionDx[d] * speed;
+  head_y += kDirectionDy[d] * speed;
 
   // Wrap the Snake around to the beginning if going off of the screen.
-  head_x = fmod(head_x + grid_width, grid_width);
-  head_y = fmod(head_y + grid_height, grid_height);
+  head_x = WrapFixed(head_x, grid_width << kFixedShift);
+  head_y = WrapFixed(head_y, grid_height << kFixedShift);
+  prev_head_x = head_x - kDirectionDx[d] * speed;
+  prev_head_y = head_y - kDirectionDy[d] * speed;
 }
 
 void Snake::UpdateBody(SDL_Point &current_head_cell, SDL_Point &prev_head_cell) {
-  // Add previous head location to vector
-  body.push_back(prev_head_cell);
+  TRACE_SCOPE("Snake::UpdateBody");
+  // Add previous head location to the body buffer. The cell is already
+  // marked in the occupancy grid from when the head entered it. GrowBody
+  // has made room for it.
+  body.PushBack(prev_head_cell);
+  dirty_cells.push_back(prev_head_cell);
+  dirty_cells.push_back(current_head_cell);
 
   if (!growing) {
-    // Remove the tail from the vector.
-    body.erase(body.begin());
+    // Remove the tail from the buffer and free its cell.
+    occupancy.Vacate(body.Front().x, body.Front().y);
+    dirty_cells.push_back(body.Front());
+    body.PopFront();
   } else {
     growing = false;
     size++;
   }
 
   // Check if the snake has died.
-  for (auto const &item : body) {
-    if (current_head_cell.x == item.x && current_head_cell.y == item.y) {
-      alive = false;
-    }
+  if (occupancy.IsOccupied(current_head_cell.x, current_head_cell.y)) {
+    alive = false;
   }
+  occupancy.Occupy(current_head_cell.x, current_head_cell.y);
 }
 
-void Snake::GrowBody() { growing = true; }
-
-// Inefficient method to check if cell is occupied by snake.
-bool Snake::SnakeCell(int x, int y) {
-  if (x == static_cast<int>(head_x) && y == static_cast<int>(head_y)) {
-    return true;
+// A move pushes the neck before it drops the tail, so the buffer needs room
+// for as many entries as the snake will have segments. It doubles up to one
+// entry per cell of the board, never during Update.
+void Snake::GrowBody() {
+  growing = true;
+  std::size_t needed = static_cast<std::size_t>(size) + 1;
+  if (needed > body.Capacity()) {
+    body.Reserve(std::min(std::max(2 * body.Capacity(), needed), static_cast<std::size_t>(grid_width) * grid_height));
   }
-  for (auto const &item : body) {
-    if (x == item.x && y == item.y) {
-      return true;
-    }
+}
+
+// Releases only the cells the snake covers, so the cost is proportional to
+// its size rather than to the grid
+void Snake::Reset() {
+  for (SDL_Point const &cell : body) {
+    occupancy.Vacate(cell.x, cell.y);
   }
-  return false;
+  occupancy.Vacate(GetHeadCell().x, GetHeadCell().y);
+  body.Clear();
+  dirty_cells.clear();
+
+  head_x = (grid_width / 2) << kFixedShift;
+  head_y = (grid_height / 2) << kFixedShift;
+  prev_head_x = head_x;
+  prev_head_y = head_y;
+  direction = Direction::kUp;
+  speed = initial_speed;
+  size = 1;
+  alive = true;
+  growing = false;
+  occupancy.Occupy(GetHeadCell().x, GetHeadCell().y);
+}
+
+// Check if cell is occupied by snake, in constant time via the occupancy grid.
+bool Snake::SnakeCell(int x, int y) const {
+  return occupancy.IsOccupied(x, y);
 }
 
 // Getter methods
@@ -100,9 +139,17 @@ Snake::Direction Snake::GetDirection() const {
 }
 
 float Snake::GetSpeed() const {
+  return static_cast<float>(speed) / kFixedOne;
+}
+
+std::int32_t Snake::GetSpeedFixed() const {
   return speed;
 }
 
+std::int32_t Snake::GetMaxSpeedFixed() const {
+  return std::min(grid_width, grid_height) << kFixedShift;
+}
+
 int Snake::GetSize() const {
   return size;
 }
@@ -112,17 +159,53 @@ bool Snake::IsAlive() const {
 }
 
 float Snake::GetHeadX() const {
-  return head_x;
+  return static_cast<float>(head_x) / kFixedOne;
 }
 
 float Snake::GetHeadY() const {
+  return static_cast<float>(head_y) / kFixedOne;
+}
+
+std::int32_t Snake::GetHeadXFixed() const {
+  return head_x;
+}
+
+std::int32_t Snake::GetHeadYFixed() const {
   return head_y;
 }
 
-std::vector<SDL_Point> Snake::GetBody() const {
+std::int32_t Snake::GetPrevHeadXFixed() const {
+  return prev_head_x;
+}
+
+std::int32_t Snake::GetPrevHeadYFixed() const {
+  return prev_head_y;
+}
+
+SDL_Point Snake::GetHeadCell() const {
+  return SDL_Point{head_x >> kFixedShift, head_y >> kFixedShift};
+}
+
+SDL_Point Snake::InterpolateHeadCell(float alpha) const {
+  return InterpolateCell(prev_head_x, prev_head_y, head_x, head_y, alpha, grid_width, grid_height);
+}
+
+RingBuffer<SDL_Point> const &Snake::GetBody() const {
   return body;
 }
 
+OccupancyGrid const &Snake::GetOccupancy() const {
+  return occupancy;
+}
+
+std::vector<SDL_Point> const &Snake::GetDirtyCells() const {
+  return dirty_cells;
+}
+
+void Snake::ClearDirtyCells() {
+  dirty_cells.clear();
+}
+
 // Setter methods
 // Set the direction of the snake
 void Snake::SetDirection(Direction direction) {
@@ -135,5 +218,15 @@ void Snake::SetSpeed(float speed) {
   if (speed <= 0) {
     throw std::invalid_argument("Speed must be positive");
   }
-  this->speed = speed;
+  // Compared before conversion so that a huge speed cannot overflow
+  SetSpeedFixed(speed < std::min(grid_width, grid_height) ? ToFixed(speed) : GetMaxSpeedFixed());
+}
+
+// Set the speed of the snake in fixed-point cells per update
+// Throws the invalid_argument exception if the speed is non-positive
+void Snake::SetSpeedFixed(std::int32_t speed) {
+  if (speed <= 0) {
+    throw std::invalid_argument("Speed must be positive");
+  }
+  this->speed = std::min(speed, GetMaxSpeedFixed());
 }
@@ -1,35 +1,97 @@
 #ifndef SNAKE_H
 #define SNAKE_H
 
+#include <cstdint>
 #include <vector>
 #include "SDL.h"
+#include "occupancy_grid.h"
+#include "ring_buffer.h"
 
 class Snake {
  public:
   // Enum to represent the direction of the snake's movement
   enum class Direction { kUp, kDown, kLeft, kRight };
 
+  // Head position and speed are fixed-point numbers in cells with
+  // kFixedShift fractional bits, so movement is exact integer arithmetic.
+  // Grids up to 16383 cells wide keep every position inside an int32.
+  static constexpr int kFixedShift = 16;
+  static constexpr std::int32_t kFixedOne = 1 << kFixedShift;
+
+  // Converts a value in cells to fixed point, rounding to nearest
+  static constexpr std::int32_t ToFixed(float cells) {
+    return static_cast<std::int32_t>(cells * kFixedOne + 0.5f);
+  }
+
+  // Body segments the snake has room for before its buffer first grows; a
+  // huge board would otherwise reserve one entry per cell up front. Boards
+  // of up to this many cells never reallocate the body after construction.
+  // On larger ones GrowBody doubles the buffer when the snake eats with it
+  // full, so Update never reallocates; each doubling copies the body once,
+  // which is amortized O(1) per segment gained.
+  static constexpr std::size_t kInitialBodyCapacity = 4096;
+
+  // Unit step along each axis, indexed by Direction
+  static constexpr std::int32_t kDirectionDx[4] = {0, 0, -1, 1};
+  static constexpr std::int32_t kDirectionDy[4] = {-1, 1, 0, 0};
+
+  // Brings a fixed-point coordinate that stepped at most one grid length out
+  // of [0, limit) back inside, without branches
+  static std::int32_t WrapFixed(std::int32_t value, std::int32_t limit) {
+    value += limit & -static_cast<std::int32_t>(value < 0);
+    value -= limit & -static_cast<std::int32_t>(value >= limit);
+    return value;
+  }
+
+  // Cell of the point a fraction alpha of the way from the unwrapped fixed-point
+  // position (x0, y0) to (x1, y1), wrapped onto the grid; double keeps alpha 1 exact
+  static SDL_Point InterpolateCell(std::int32_t x0, std::int32_t y0, std::int32_t x1, std::int32_t y1, float alpha,
+                                   int grid_width, int grid_height) {
+    std::int32_t x = WrapFixed(x0 + static_cast<std::int32_t>(static_cast<double>(x1 - x0) * alpha),
+                               grid_width << kFixedShift);
+    std::int32_t y = WrapFixed(y0 + static_cast<std::int32_t>(static_cast<double>(y1 - y0) * alpha),
+                               grid_height << kFixedShift);
+    return SDL_Point{x >> kFixedShift, y >> kFixedShift};
+  }
+
+  // Speed of a new snake in cells per update
+  static constexpr float kDefaultSpeed = 0.1f;
+
   // Constructor
   // Initializes the snake at the center of the grid 
-  Snake(int grid_width, int grid_height);
+  // Throws invalid_argument unless initial_speed is positive and less than
+  // the smaller grid size
+  Snake(int grid_width, int grid_height, float initial_speed = kDefaultSpeed);
 
   // Updates the snake's position and check for collisions
   void Update();
 
-  // Sets the snake's length to grow by one whenever the snake eats food
+  // Sets the snake's length to grow by one whenever the snake eats food,
+  // first making room in the body buffer for the new segment if needed
   void GrowBody();
 
+  // Puts the snake back in its initial state at the center of the grid,
+  // reusing its buffers instead of allocating new ones
+  void Reset();
+
   // Check if a given cell is occupied by the snake
-  bool SnakeCell(int x, int y);
+  bool SnakeCell(int x, int y) const;
 
   // Public getter methods
 
   // Gets the current direction of the snake
   Direction GetDirection() const;
 
-  // Gets the current speed of the snake
+  // Gets the current speed of the snake in cells per update
   float GetSpeed() const;
 
+  // Gets the current speed of the snake in fixed-point cells per update
+  std::int32_t GetSpeedFixed() const;
+
+  // Gets the highest speed in fixed point: one grid length per update, the
+  // furthest a step can go and still be wrapped back onto the board
+  std::int32_t GetMaxSpeedFixed() const;
+
   // Get the current size of the snake
   int GetSize() const;
 
@@ -42,18 +104,51 @@ class Snake {
   // Get the y-coordinate of the snake
   float GetHeadY() const;
 
-  // Get the body of the snake
-  std::vector<SDL_Point> GetBody() const;
+  // Get the coordinates of the snake in fixed point
+  std::int32_t GetHeadXFixed() const;
+  std::int32_t GetHeadYFixed() const;
+
+  // Get the coordinates of the head before the last update in fixed point,
+  // not wrapped onto the grid
+  std::int32_t GetPrevHeadXFixed() const;
+  std::int32_t GetPrevHeadYFixed() const;
+
+  // Get the cell the snake's head is in
+  SDL_Point GetHeadCell() const;
+
+  // Get the cell the head was in a fraction alpha (0 to 1) of the way from
+  // its position before the last update to its current one; used to render
+  // between fixed simulation ticks without guessing the next one
+  SDL_Point InterpolateHeadCell(float alpha) const;
+
+  // Get the body of the snake, ordered from the tail to the segment behind
+  // the head
+  RingBuffer<SDL_Point> const &GetBody() const;
+
+  // Get the grid of cells covered by the snake
+  OccupancyGrid const &GetOccupancy() const;
+
+  // Get the cells whose content changed since the last ClearDirtyCells call:
+  // the cell the head entered, the cell it left and the vacated tail cell
+  std::vector<SDL_Point> const &GetDirtyCells() const;
+
+  // Forget the changed cells once they have been consumed
+  void ClearDirtyCells();
 
   // Public setter methods
 
   // Set the direction of the snake
   void SetDirection(Direction direction);
 
-  // Set the speed of the snake
+  // Set the speed of the snake; faster speeds are capped at the maximum
   // Throws invalid_argument if speed is non-positive
   void SetSpeed(float speed);
 
+  // Set the speed of the snake in fixed-point cells per update; faster
+  // speeds are capped at the maximum
+  // Throws invalid_argument if speed is non-positive
+  void SetSpeedFixed(std::int32_t speed);
+
   private:
     // Update the position of the snake's head based on its direction
     void UpdateHead();
@@ -61,15 +156,22 @@ class Snake {
     void UpdateBody(SDL_Point &current_cell, SDL_Point &prev_cell);
 
     Direction direction; // The current direction of the snake
-    float speed; // The speed at which the snake moves
+    std::int32_t speed; // The speed at which the snake moves, fixed point
+    std::int32_t initial_speed; // The speed Reset restores, fixed point
     int size; // The current size of the snake
     bool alive; // The alive status of the snake
-    float head_x; // The x-coordinate of the snake's head
-    float head_y; // The y-coordinate of the snake's head
-    std::vector<SDL_Point> body; // The current body of the snake
+    std::int32_t head_x; // The x-coordinate of the snake's head, fixed point
+    std::int32_t head_y; // The y-coordinate of the snake's head, fixed point
+    // Head position before the last update, fixed point; not wrapped, so the
+    // difference to the head is the last step even across the board's edge
+    std::int32_t prev_head_x;
+    std::int32_t prev_head_y;
+    RingBuffer<SDL_Point> body; // The current body of the snake
     bool growing; // Indicates if the snake will grow in the next update
     int grid_width; // The width of the grid
     int grid_height; // The height of the grid
+    OccupancyGrid occupancy; // Cells covered by the head and the body
+    std::vector<SDL_Point> dirty_cells; // Cells changed since the last ClearDirtyCells
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,714 @@
+// Headless simulation benchmark
+// Drives Snake::Update, Game::Update, SnakePool::Update, ObservationEncoder,
+// VecEnv::Step and Autopilot without a window or SDL input and reports throughput, per-tick
+// latency percentiles and the peak resident memory of each scenario for a
+// range of grid sizes, snake lengths and snake counts. Every
+// arena runs twice from the same seed, once on one thread and once on a
+// thread pool, and the two runs must end with the same checksum. The SIMD
+// head kernel is checked against Snake::Update and timed per instruction set,
+// incremental observations are checked against full rebuilds, and VecEnv
+// games are checked against Game.
+//
+// Usage: snake_bench [ticks_per_scenario] [arena_threads] [--preset name]
+//                    [--config file] [--key value ...]
+// The game rows take the tick rate, snake speed and speed step from the
+// settings, and the seed if one is set; every row sets its own grid, and the
+// other settings do not apply. The settings used are echoed before the
+// results as "# key = value" lines.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "autopilot.h"
+#include "config.h"
+#include "game.h"
+#include "head_kernel.h"
+#include "observation_encoder.h"
+#include "snake.h"
+#include "snake_pool.h"
+#include "thread_pool.h"
+#include "vec_env.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Per-tick timings of one scenario
+struct Samples {
+  std::vector<std::uint32_t> ns;
+  Clock::duration total{0};
+};
+
+// Resets the process's resident high-water mark to its current size, so
+// PeakMemoryKb reports the peak of the scenario that follows rather than of
+// every scenario so far (Linux 4.0 and later). Returns false if it cannot.
+bool ResetPeakMemory() {
+#ifdef __GLIBC__
+  // Hand the heap freed by earlier scenarios back to the system first
+  malloc_trim(0);
+#endif
+  std::FILE *file = std::fopen("/proc/self/clear_refs", "w");
+  if (file == nullptr) return false;
+  bool written = std::fputs("5", file) >= 0;
+  return std::fclose(file) == 0 && written;
+}
+
+// Peak resident set size since the last ResetPeakMemory, in kilobytes; the
+// peak of the whole run where /proc is not available
+long PeakMemoryKb() {
+  long peak = -1;
+  if (std::FILE *file = std::fopen("/proc/self/status", "r")) {
+    char line[256];
+    while (std::fgets(line, sizeof(line), file) != nullptr) {
+      if (std::strncmp(line, "VmHWM:", 6) == 0) std::sscanf(line + 6, "%ld", &peak);
+    }
+    std::fclose(file);
+  }
+  if (peak >= 0) return peak;
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+std::uint32_t Percentile(std::vector<std::uint32_t> &values, double fraction) {
+  std::size_t index = static_cast<std::size_t>(fraction * (values.size() - 1));
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
+void PrintHeader() {
+  // The length column holds the snake's length, or the number of snakes for
+  // arena and kernel rows
+  std::printf("%-13s %11s %8s %10s %12s %8s %8s %9s %12s\n", "target", "grid", "length",
+              "ticks", "ticks/s", "p50 ns", "p99 ns", "max ns", "peak RSS KB");
+}
+
+void PrintRow(char const *target, int grid, int length, Samples &samples) {
+  double seconds = std::chrono::duration<double>(samples.total).count();
+  double ticks_per_second = samples.ns.size() / seconds;
+  std::uint32_t max = *std::max_element(samples.ns.begin(), samples.ns.end());
+  std::uint32_t p99 = Percentile(samples.ns, 0.99);
+  std::uint32_t p50 = Percentile(samples.ns, 0.50);
+  std::printf("%-13s %5dx%-5d %8d %10zu %12.0f %8u %8u %9u %12ld\n", target, grid, grid, length,
+              samples.ns.size(), ticks_per_second, p50, p99, max, PeakMemoryKb());
+}
+
+// Direction that walks every cell of the board in a closed serpentine loop:
+// right along even rows, left along odd rows, down at the row ends. The loop
+// wraps from the last row to the first, so a snake shorter than the board
+// following it never runs into itself. Needs an even grid height.
+Snake::Direction SerpentineDirection(SDL_Point const &cell, int grid_width) {
+  if (cell.y % 2 == 0) {
+    return cell.x < grid_width - 1 ? Snake::Direction::kRight : Snake::Direction::kDown;
+  }
+  return cell.x > 0 ? Snake::Direction::kLeft : Snake::Direction::kDown;
+}
+
+// Snake::Update on a snake of the given length moving one cell per tick
+void BenchSnake(int grid, int length, std::size_t ticks) {
+  ResetPeakMemory();
+  Snake snake(grid, grid);
+  snake.SetSpeed(1.0f);
+
+  // Grow the snake to the requested length along the serpentine path
+  while (snake.GetSize() < length) {
+    snake.SetDirection(SerpentineDirection(snake.GetHeadCell(), grid));
+    snake.GrowBody();
+    snake.Update();
+    snake.ClearDirtyCells();
+  }
+
+  Samples samples;
+  samples.ns.reserve(ticks);
+  for (std::size_t i = 0; i < ticks; ++i) {
+    snake.SetDirection(SerpentineDirection(snake.GetHeadCell(), grid));
+    Clock::time_point start = Clock::now();
+    snake.Update();
+    snake.ClearDirtyCells();
+    Clock::duration elapsed = Clock::now() - start;
+    samples.total += elapsed;
+    samples.ns.push_back(static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+  }
+  if (!snake.IsAlive()) {
+    std::fprintf(stderr, "snake died on the serpentine path, results are not representative\n");
+  }
+  PrintRow("snake", grid, length, samples);
+}
+
+// Game::Update with random turns at the configured game speed; a new game
+// is started (outside the timed region) whenever the snake dies
+void BenchGame(Config config, int grid, std::size_t ticks, std::mt19937 &engine) {
+  ResetPeakMemory();
+  config.grid_width = config.grid_height = static_cast<std::size_t>(grid);
+  Snake::Direction const directions[] = {Snake::Direction::kUp, Snake::Direction::kDown,
+                                         Snake::Direction::kLeft, Snake::Direction::kRight};
+  std::uniform_int_distribution<int> pick_direction(0, 3);
+  std::uniform_int_distribution<int> pick_turn(0, 7);
+
+  auto game = std::make_unique<Game>(config, engine());
+  Samples samples;
+  samples.ns.reserve(ticks);
+  for (std::size_t i = 0; i < ticks; ++i) {
+    if (!game->GetSnake().IsAlive()) {
+      game = std::make_unique<Game>(config, engine());
+    }
+    Snake &snake = game->GetSnake();
+    if (pick_turn(engine) == 0) {
+      Snake::Direction turn = directions[pick_direction(engine)];
+      bool reverse = (turn == Snake::Direction::kUp && snake.GetDirection() == Snake::Direction::kDown) ||
+                     (turn == Snake::Direction::kDown && snake.GetDirection() == Snake::Direction::kUp) ||
+                     (turn == Snake::Direction::kLeft && snake.GetDirection() == Snake::Direction::kRight) ||
+                     (turn == Snake::Direction::kRight && snake.GetDirection() == Snake::Direction::kLeft);
+      if (!reverse || snake.GetSize() == 1) snake.SetDirection(turn);
+    }
+    Clock::time_point start = Clock::now();
+    game->Update();
+    Clock::duration elapsed = Clock::now() - start;
+    samples.total += elapsed;
+    samples.ns.push_back(static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+  }
+  PrintRow("game", grid, game->GetSize(), samples);
+}
+
+// SnakePool::Update on an arena of many snakes. Untimed, each snake steers
+// away from an occupied cell ahead, turns at random now and then and grows
+// until it reaches max_length; dead snakes respawn at a random cell. Runs the
+// proposal phase on threads if given. Returns the final checksum.
+std::uint64_t BenchArena(int grid, int snakes, std::size_t ticks, std::uint32_t seed,
+                         ThreadPool *threads) {
+  ResetPeakMemory();
+  constexpr int kMaxLength = 64;
+  std::mt19937 engine(seed);
+  SnakePool pool(grid, grid, snakes, kMaxLength);
+  std::uniform_int_distribution<int> pick_cell(0, grid - 1);
+  std::uniform_int_distribution<int> pick_direction(0, 3);
+  std::uniform_int_distribution<int> pick_event(0, 15);
+  for (int attempts = 0; pool.Count() < snakes && attempts < 4 * snakes; ++attempts) {
+    pool.Spawn(pick_cell(engine), pick_cell(engine),
+               static_cast<Snake::Direction>(pick_direction(engine)), Snake::ToFixed(0.5f));
+  }
+
+  OccupancyGrid const &occupancy = pool.GetOccupancy();
+  Samples samples;
+  samples.ns.reserve(ticks);
+  for (std::size_t t = 0; t < ticks; ++t) {
+    for (int i = 0; i < pool.Count(); ++i) {
+      if (!pool.IsAlive(i)) {
+        pool.Respawn(i, pick_cell(engine), pick_cell(engine),
+                     static_cast<Snake::Direction>(pick_direction(engine)));
+        continue;
+      }
+      int event = pick_event(engine);
+      if (event == 0) pool.Grow(i);
+      SDL_Point head = pool.GetHeadCell(i);
+      int d = static_cast<int>(pool.GetDirection(i));
+      int ahead_x = (head.x + Snake::kDirectionDx[d] + grid) % grid;
+      int ahead_y = (head.y + Snake::kDirectionDy[d] + grid) % grid;
+      if (event == 1 || occupancy.IsOccupied(ahead_x, ahead_y)) {
+        pool.SetDirection(i, static_cast<Snake::Direction>(pick_direction(engine)));
+      }
+    }
+    Clock::time_point start = Clock::now();
+    if (threads) {
+      pool.Update(*threads);
+    } else {
+      pool.Update();
+    }
+    Clock::duration elapsed = Clock::now() - start;
+    samples.total += elapsed;
+    samples.ns.push_back(static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+  }
+  PrintRow(threads ? "arenaP" : "arena", grid, pool.Count(), samples);
+  return pool.Checksum();
+}
+
+// Fills a head batch with snakes spread over the board at assorted speeds,
+// a sixteenth of them dead
+struct HeadArrays {
+  std::vector<std::int32_t> x, y, direction, speed, next_x, next_y;
+  std::vector<std::uint8_t> alive, moved;
+
+  HeadArrays(int count, int grid_width, int grid_height, std::mt19937 &engine)
+    : x(count), y(count), direction(count), speed(count), next_x(count), next_y(count),
+      alive(count), moved(count) {
+    std::uniform_int_distribution<std::int32_t> pick_x(0, (grid_width << Snake::kFixedShift) - 1);
+    std::uniform_int_distribution<std::int32_t> pick_y(0, (grid_height << Snake::kFixedShift) - 1);
+    std::uniform_int_distribution<std::int32_t> pick_speed(1, 2 * Snake::kFixedOne);
+    std::uniform_int_distribution<int> pick_direction(0, 3);
+    std::uniform_int_distribution<int> pick_dead(0, 15);
+    for (int i = 0; i < count; ++i) {
+      x[i] = pick_x(engine);
+      y[i] = pick_y(engine);
+      direction[i] = pick_direction(engine);
+      speed[i] = pick_speed(engine);
+      alive[i] = pick_dead(engine) != 0;
+    }
+  }
+
+  HeadBatch Batch(int grid_width, int grid_height) {
+    return HeadBatch{x.data(), y.data(), direction.data(), speed.data(), alive.data(),
+                     next_x.data(), next_y.data(), moved.data(),
+                     grid_width << Snake::kFixedShift, grid_height << Snake::kFixedShift};
+  }
+};
+
+// Steps single-segment snakes with Snake::Update and the same heads with the
+// kernel, turning at random, and counts heads whose position or cell-change
+// flag differs. An odd head count exercises the scalar tail of the SIMD paths.
+int VerifyHeadKernel(HeadKernel::Isa isa, std::mt19937 &engine) {
+  constexpr int kGridWidth = 37;
+  constexpr int kGridHeight = 23;
+  constexpr int kHeads = 1001;
+  constexpr int kSteps = 500;
+  HeadArrays heads(kHeads, kGridWidth, kGridHeight, engine);
+  HeadBatch batch = heads.Batch(kGridWidth, kGridHeight);
+  std::uniform_int_distribution<int> pick_direction(0, 3);
+
+  int mismatches = 0;
+  for (int i = 0; i < kHeads; ++i) {
+    // Snake starts at the centre; the kernel batch starts from the same spot
+    Snake snake(kGridWidth, kGridHeight);
+    snake.SetSpeedFixed(heads.speed[i]);
+    heads.x[i] = snake.GetHeadXFixed();
+    heads.y[i] = snake.GetHeadYFixed();
+    for (int step = 0; step < kSteps; ++step) {
+      heads.direction[i] = pick_direction(engine);
+      snake.SetDirection(static_cast<Snake::Direction>(heads.direction[i]));
+      SDL_Point before = snake.GetHeadCell();
+      if (heads.alive[i]) snake.Update();
+      snake.ClearDirtyCells();
+      SDL_Point after = snake.GetHeadCell();
+
+      HeadKernel::Advance(isa, batch, i, i + 1);
+      bool moved = before.x != after.x || before.y != after.y;
+      if (heads.next_x[i] != snake.GetHeadXFixed() || heads.next_y[i] != snake.GetHeadYFixed() ||
+          (heads.moved[i] != 0) != moved) {
+        mismatches++;
+        break;
+      }
+      heads.x[i] = heads.next_x[i];
+      heads.y[i] = heads.next_y[i];
+    }
+  }
+
+  // Whole-batch calls must agree with the scalar path lane for lane
+  HeadArrays reference(kHeads, kGridWidth, kGridHeight, engine);
+  HeadArrays vector = reference;
+  HeadBatch reference_batch = reference.Batch(kGridWidth, kGridHeight);
+  HeadBatch vector_batch = vector.Batch(kGridWidth, kGridHeight);
+  for (int step = 0; step < kSteps; ++step) {
+    HeadKernel::Advance(HeadKernel::Isa::kScalar, reference_batch, 0, kHeads);
+    HeadKernel::Advance(isa, vector_batch, 0, kHeads);
+    if (reference.next_x != vector.next_x || reference.next_y != vector.next_y ||
+        reference.moved != vector.moved) {
+      mismatches++;
+      break;
+    }
+    reference.x.swap(reference.next_x);
+    reference.y.swap(reference.next_y);
+    vector.x.swap(vector.next_x);
+    vector.y.swap(vector.next_y);
+    reference_batch = reference.Batch(kGridWidth, kGridHeight);
+    vector_batch = vector.Batch(kGridWidth, kGridHeight);
+  }
+  return mismatches;
+}
+
+// HeadKernel::Advance over a batch of heads on a 1024x1024 board
+void BenchHeadKernel(HeadKernel::Isa isa, int heads, std::size_t ticks, std::mt19937 &engine) {
+  ResetPeakMemory();
+  constexpr int kGrid = 1024;
+  HeadArrays arrays(heads, kGrid, kGrid, engine);
+  Samples samples;
+  samples.ns.reserve(ticks);
+  for (std::size_t t = 0; t < ticks; ++t) {
+    HeadBatch batch = arrays.Batch(kGrid, kGrid);
+    Clock::time_point start = Clock::now();
+    HeadKernel::Advance(isa, batch, 0, heads);
+    Clock::duration elapsed = Clock::now() - start;
+    samples.total += elapsed;
+    samples.ns.push_back(static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    arrays.x.swap(arrays.next_x);
+    arrays.y.swap(arrays.next_y);
+  }
+  char target[16];
+  std::snprintf(target, sizeof(target), "kernel/%s", HeadKernel::Name(isa));
+  PrintRow(target, kGrid, heads, samples);
+}
+
+// ObservationEncoder on a snake of the given length on the serpentine path,
+// with the food jumping to a random free cell every eighth step. Times the
+// full Encode and the incremental Update into separate buffers and returns
+// false if the two observations ever differ.
+bool BenchObservation(int grid, int length, std::size_t steps, std::mt19937 &engine) {
+  ResetPeakMemory();
+  Snake snake(grid, grid);
+  snake.SetSpeed(1.0f);
+  while (snake.GetSize() < length) {
+    snake.SetDirection(SerpentineDirection(snake.GetHeadCell(), grid));
+    snake.GrowBody();
+    snake.Update();
+  }
+  snake.ClearDirtyCells();
+
+  SDL_Point food{-1, -1};
+  SDL_Point const no_bonus_food{-1, -1};
+  ObservationEncoder full_encoder(grid, grid);
+  ObservationEncoder incremental_encoder(grid, grid);
+  std::vector<std::uint8_t> full(full_encoder.Size());
+  std::vector<std::uint8_t> incremental(incremental_encoder.Size());
+  incremental_encoder.Encode(snake, food, no_bonus_food, incremental.data());
+
+  Samples full_samples;
+  Samples incremental_samples;
+  full_samples.ns.reserve(steps);
+  incremental_samples.ns.reserve(steps);
+  bool identical = true;
+  for (std::size_t t = 0; t < steps; ++t) {
+    snake.SetDirection(SerpentineDirection(snake.GetHeadCell(), grid));
+    snake.Update();
+    if (t % 8 == 0) snake.GetOccupancy().RandomFreeCell(engine, food);
+
+    Clock::time_point start = Clock::now();
+    full_encoder.Encode(snake, food, no_bonus_food, full.data());
+    Clock::duration elapsed = Clock::now() - start;
+    full_samples.total += elapsed;
+    full_samples.ns.push_back(static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+
+    start = Clock::now();
+    incremental_encoder.Update(snake, food, no_bonus_food, snake.GetDirtyCells(), incremental.data());
+    elapsed = Clock::now() - start;
+    incremental_samples.total += elapsed;
+    incremental_samples.ns.push_back(static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+
+    snake.ClearDirtyCells();
+    identical = identical && full == incremental;
+  }
+  PrintRow("obs/full", grid, length, full_samples);
+  PrintRow("obs/incr", grid, length, incremental_samples);
+  return identical;
+}
+
+// Autopilot::NextDirection steering a snake moving one cell per tick to
+// random food, so the path is re-planned every time food is eaten. The
+// snake restarts when it dies.
+void BenchAutopilot(int grid, std::size_t ticks, std::mt19937 &engine) {
+  ResetPeakMemory();
+  Snake snake(grid, grid);
+  snake.SetSpeed(1.0f);
+  Autopilot autopilot(grid, grid);
+  SDL_Point food{-1, -1};
+  snake.GetOccupancy().RandomFreeCell(engine, food);
+
+  Samples samples;
+  samples.ns.reserve(ticks);
+  int deaths = 0;
+  for (std::size_t t = 0; t < ticks; ++t) {
+    Clock::time_point start = Clock::now();
+    Snake::Direction direction = autopilot.NextDirection(snake, food);
+    Clock::duration elapsed = Clock::now() - start;
+    samples.total += elapsed;
+    samples.ns.push_back(static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+
+    snake.SetDirection(direction);
+    snake.Update();
+    snake.ClearDirtyCells();
+    SDL_Point head = snake.GetHeadCell();
+    if (!snake.IsAlive()) {
+      deaths++;
+      snake.Reset();
+      snake.SetSpeed(1.0f);
+      snake.GetOccupancy().RandomFreeCell(engine, food);
+    } else if (head.x == food.x && head.y == food.y) {
+      snake.GrowBody();
+      if (!snake.GetOccupancy().RandomFreeCell(engine, head, food)) {
+        food = SDL_Point{-1, -1};
+      }
+    }
+  }
+  PrintRow("autopilot", grid, snake.GetSize(), samples);
+  std::printf("  %zu searches, %d deaths\n", autopilot.GetSearchCount(), deaths);
+}
+
+// Autopilot::NextDirection while the food is walled in. Untimed, the snake
+// moves left for most of a row, then circles the cell above and to the left
+// of its head, so its body rings the food, and leaves the ring downwards.
+// Timed, it follows the autopilot, growing every other tick, until its tail
+// comes close to the ring or it dies; then the walls are built again.
+void BenchUnreachable(int grid, std::size_t ticks) {
+  ResetPeakMemory();
+  using Direction = Snake::Direction;
+  Direction const ring[] = {Direction::kUp, Direction::kUp, Direction::kLeft, Direction::kLeft,
+                            Direction::kDown, Direction::kDown, Direction::kRight, Direction::kDown};
+  int const line = grid - 4;
+  Snake snake(grid, grid);
+  Autopilot autopilot(grid, grid);
+  SDL_Point food{-1, -1};
+
+  Samples samples;
+  samples.ns.reserve(ticks);
+  int walls = 0;
+  std::size_t episode_ticks = 0;
+  for (std::size_t t = 0; t < ticks; ++t) {
+    if (!snake.IsAlive() || episode_ticks == 0) {
+      snake.Reset();
+      snake.SetSpeed(1.0f);
+      for (int i = 0; i < line + 8; ++i) {
+        snake.SetDirection(i < line ? Direction::kLeft : ring[i - line]);
+        if (i == line) food = SDL_Point{snake.GetHeadCell().x - 1, snake.GetHeadCell().y - 1};
+        snake.GrowBody();
+        snake.Update();
+        snake.ClearDirtyCells();
+      }
+      walls++;
+      episode_ticks = 2 * static_cast<std::size_t>(line) - 4;
+    }
+    Clock::time_point start = Clock::now();
+    Direction direction = autopilot.NextDirection(snake, food);
+    Clock::duration elapsed = Clock::now() - start;
+    samples.total += elapsed;
+    samples.ns.push_back(static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+
+    snake.SetDirection(direction);
+    if (t % 2 == 0) snake.GrowBody();
+    snake.Update();
+    snake.ClearDirtyCells();
+    episode_ticks--;
+  }
+  PrintRow("nopath", grid, snake.GetSize(), samples);
+  std::printf("  %zu searches, walls built %d times\n", autopilot.GetSearchCount(), walls);
+}
+
+// Plays single VecEnv games next to Games given the same rules (one cell per
+// tick, no speed step, no bonus food) and the same seed, feeding both the
+// same turns until the game ends: mostly random moves onto free cells, now
+// and then any move. The Game takes its turns through the input queue, as
+// from the keyboard, and an ObservationEncoder patches the Game's planes from
+// Game::GetChangedCells. Returns the number of episodes in which the head,
+// size, score, covered cells, observation, reward or end of the game ever differ.
+int VerifyVecEnv(std::mt19937 &engine) {
+  constexpr int kEpisodes = 40;
+  constexpr int kMaxSteps = 5000;
+  SDL_Point const boards[] = {{2, 9}, {5, 7}, {8, 8}};
+  std::uniform_int_distribution<int> pick_direction(0, 3);
+  std::uniform_int_distribution<int> pick_event(0, 15);
+
+  int mismatches = 0;
+  for (SDL_Point const &board : boards) {
+    Config config;
+    config.grid_width = static_cast<std::size_t>(board.x);
+    config.grid_height = static_cast<std::size_t>(board.y);
+    config.initial_speed = 1.0f;
+    config.speed_step = 0.0f;
+    VecEnv env(1, board.x, board.y, 1);
+    ObservationEncoder encoder(board.x, board.y);
+    std::vector<std::uint8_t> planes(encoder.Size());
+    for (int episode = 0; episode < kEpisodes; ++episode) {
+      std::uint32_t seed = engine();
+      Game game(config, seed);
+      game.SetBonusFoodEnabled(false);
+      VecEnv::StepResult reset = env.Reset(&seed);
+      Snake const &snake = game.GetSnake();
+      encoder.Encode(snake, game.GetFood(), game.GetBonusFood(), planes.data());
+
+      bool same = std::memcmp(planes.data(), reset.observations, planes.size()) == 0;
+      for (int step = 0; step < kMaxSteps && same; ++step) {
+        int direction = pick_direction(engine);
+        for (int tries = 0; tries < 4 && pick_event(engine) != 0; ++tries) {
+          SDL_Point head = env.GetHeadCell(0);
+          int ahead_x = (head.x + Snake::kDirectionDx[direction] + board.x) % board.x;
+          int ahead_y = (head.y + Snake::kDirectionDy[direction] + board.y) % board.y;
+          if (!env.IsOccupied(0, ahead_x, ahead_y)) break;
+          direction = (direction + 1) % 4;
+        }
+        std::uint8_t action = static_cast<std::uint8_t>(direction);
+        int score = game.GetScore();
+        game.GetInputQueue().Push(InputCommand{static_cast<Snake::Direction>(direction), Clock::now()});
+        VecEnv::StepResult result = env.Step(&action);
+        game.Update();
+
+        bool ended = !snake.IsAlive() || game.IsBoardFull();
+        float reward = !snake.IsAlive() ? VecEnv::kDeathReward
+                                        : (game.GetScore() > score ? VecEnv::kFoodReward : 0.0f);
+        same = result.dones[0] == ended && result.rewards[0] == reward;
+        // A VecEnv game that ended has already restarted
+        if (ended) break;
+        SDL_Point head = snake.GetHeadCell();
+        same = same && head.x == env.GetHeadCell(0).x && head.y == env.GetHeadCell(0).y &&
+               snake.GetSize() == env.GetSize(0) && game.GetScore() == env.GetScore(0);
+        for (int y = 0; y < board.y && same; ++y) {
+          for (int x = 0; x < board.x && same; ++x) {
+            same = snake.SnakeCell(x, y) == env.IsOccupied(0, x, y);
+          }
+        }
+        encoder.Update(snake, game.GetFood(), game.GetBonusFood(), game.GetChangedCells(), planes.data());
+        same = same && std::memcmp(planes.data(), result.observations, planes.size()) == 0;
+      }
+      if (!same) mismatches++;
+    }
+  }
+  return mismatches;
+}
+
+// VecEnv::Step over many small games with random actions, drawn untimed.
+// The ticks/s column counts batch steps; each moves every game once.
+void BenchVecEnv(int grid, int envs, std::size_t steps, int threads, std::mt19937 &engine) {
+  ResetPeakMemory();
+  VecEnv env(envs, grid, grid, threads);
+  std::vector<std::uint32_t> seeds(envs);
+  for (std::uint32_t &seed : seeds) seed = engine();
+  env.Reset(seeds.data());
+
+  std::vector<std::uint8_t> actions(envs);
+  std::uniform_int_distribution<int> pick_direction(0, 3);
+  Samples samples;
+  samples.ns.reserve(steps);
+  long episodes = 0;
+  for (std::size_t t = 0; t < steps; ++t) {
+    for (std::uint8_t &action : actions) action = static_cast<std::uint8_t>(pick_direction(engine));
+    Clock::time_point start = Clock::now();
+    VecEnv::StepResult result = env.Step(actions.data());
+    Clock::duration elapsed = Clock::now() - start;
+    samples.total += elapsed;
+    samples.ns.push_back(static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    for (int i = 0; i < envs; ++i) episodes += result.dones[i];
+  }
+  PrintRow("vecenv", grid, envs, samples);
+  double seconds = std::chrono::duration<double>(samples.total).count();
+  std::printf("  %.0f env steps/s, %ld episodes ended\n", steps * envs / seconds, episodes);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  // Numbers are the positional arguments; everything from the first flag on configures the game
+  std::vector<std::string> positional;
+  std::vector<std::string> settings;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg(argv[i]);
+    if (settings.empty() && arg.compare(0, 2, "--") != 0) {
+      positional.push_back(arg);
+    } else {
+      settings.push_back(arg);
+    }
+  }
+  Config config;
+  try {
+    config.ParseArgs(settings);
+    // The smallest game row must take the initial speed too
+    Config smallest = config;
+    smallest.grid_width = smallest.grid_height = 32;
+    smallest.Validate();
+  } catch (std::exception const &error) {
+    std::fprintf(stderr, "%s\n", error.what());
+    return 1;
+  }
+  std::size_t ticks = 200000;
+  if (positional.size() > 0) ticks = std::strtoull(positional[0].c_str(), nullptr, 10);
+  if (ticks == 0 || positional.size() > 2) {
+    std::fprintf(stderr, "usage: %s [ticks_per_scenario] [arena_threads] [--preset name] [--config file] "
+                 "[--key value ...]\n", argv[0]);
+    return 1;
+  }
+  int arena_threads = static_cast<int>(std::thread::hardware_concurrency());
+  if (positional.size() > 1) arena_threads = std::atoi(positional[1].c_str());
+  ThreadPool threads(std::max(arena_threads, 1));
+
+  int const grids[] = {32, 256, 1024};
+  int const lengths[] = {1, 1000, 30000};
+  std::mt19937 engine(config.seed ? *config.seed : 42);
+
+  std::printf("# ticks_per_scenario = %zu\n# arena_threads = %d\n", ticks, threads.Size());
+  std::printf("# ticks_per_second = %zu\n# initial_speed = %g\n# speed_step = %g\n# seed = %u\n",
+              config.ticks_per_second, config.initial_speed, config.speed_step, config.seed ? *config.seed : 42);
+  if (!ResetPeakMemory()) std::printf("# peak RSS is the peak of the run so far, not of each row\n");
+  PrintHeader();
+  for (int grid : grids) {
+    for (int length : lengths) {
+      if (length >= grid * grid) continue;
+      BenchSnake(grid, length, ticks);
+    }
+  }
+  for (int grid : grids) {
+    BenchGame(config, grid, ticks, engine);
+  }
+  // Kernel rows advance 10000 heads per tick with each supported instruction set
+  bool identical = true;
+  HeadKernel::Isa const kernels[] = {HeadKernel::Isa::kScalar, HeadKernel::Isa::kSse2,
+                                     HeadKernel::Isa::kAvx2};
+  for (HeadKernel::Isa isa : kernels) {
+    if (!HeadKernel::Supported(isa)) continue;
+    if (VerifyHeadKernel(isa, engine) != 0) {
+      std::fprintf(stderr, "%s head kernel disagrees with Snake::Update\n", HeadKernel::Name(isa));
+      identical = false;
+    }
+    BenchHeadKernel(isa, 10000, std::max<std::size_t>(ticks / 10, 1), engine);
+  }
+  // Arena rows run a tenth of the ticks: every tick moves thousands of snakes.
+  // arenaP rows repeat the arena on the thread pool.
+  int const arena_snakes[] = {100, 1000, 10000};
+  for (int snakes : arena_snakes) {
+    std::size_t arena_ticks = std::max<std::size_t>(ticks / 10, 1);
+    std::uint32_t seed = engine();
+    std::uint64_t serial = BenchArena(1024, snakes, arena_ticks, seed, nullptr);
+    std::uint64_t parallel = BenchArena(1024, snakes, arena_ticks, seed, &threads);
+    if (serial != parallel) {
+      std::fprintf(stderr, "arena with %d snakes: parallel run diverged from the serial run\n", snakes);
+      identical = false;
+    }
+  }
+  // Autopilot rows plan a path every time food is eaten; nopath rows steer
+  // a snake whose body walls the food in
+  for (int grid : grids) {
+    BenchAutopilot(grid, std::max<std::size_t>(ticks / 10, 1), engine);
+  }
+  for (int grid : grids) {
+    BenchUnreachable(grid, std::max<std::size_t>(ticks / 10, 1));
+  }
+  // Observation rows encode one snake per step, fully and incrementally
+  for (int grid : {32, 256}) {
+    for (int length : {1, 1000}) {
+      if (!BenchObservation(grid, length, std::max<std::size_t>(ticks / 100, 1), engine)) {
+        std::fprintf(stderr, "incremental observation of %dx%d, length %d differs from a full encode\n",
+                     grid, grid, length);
+        identical = false;
+      }
+    }
+  }
+  // VecEnv rows step 1024 and 16384 games of 16x16 on the arena threads,
+  // once single games have been checked against Game
+  if (int diverged = VerifyVecEnv(engine)) {
+    std::fprintf(stderr, "%d VecEnv games diverged from Game\n", diverged);
+    identical = false;
+  }
+  for (int envs : {1024, 16384}) {
+    BenchVecEnv(16, envs, std::max<std::size_t>(ticks / 100, 1), threads.Size(), engine);
+  }
+  // Huge-board row last; where the peak cannot be reset, its memory would
+  // otherwise inflate the peak RSS of every row after it
+  BenchGame(config, 4096, ticks, engine);
+  std::printf("arenaP and vecenv rows used %d threads, arena head kernel: %s\n", threads.Size(),
+              HeadKernel::Name(HeadKernel::Detect()));
+  return identical ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+#include "snake_pool.h"
+#include <algorithm>
+
+// Constructor
+// Every array is sized for max_snakes up front
+SnakePool::SnakePool(int grid_width, int grid_height, int max_snakes, int max_length)
+  : grid_width(grid_width),
+    grid_height(grid_height),
+    max_snakes(max_snakes),
+    max_length(max_length),
+    occupancy(grid_width, grid_height),
+    head_x(max_snakes),
+    head_y(max_snakes),
+    direction(max_snakes),
+    speed(max_snakes),
+    size(max_snakes),
+    alive(max_snakes),
+    growing(max_snakes),
+    moved(max_snakes),
+    next_x(max_snakes),
+    next_y(max_snakes),
+    target_cell(max_snakes),
+    released_cell(max_snakes),
+    body_cells(static_cast<std::size_t>(max_snakes) * max_length),
+    body_first(max_snakes),
+    body_count(max_snakes) {}
+
+int SnakePool::Spawn(int x, int y, Snake::Direction direction, std::int32_t speed) {
+  if (count == max_snakes || occupancy.IsOccupied(x, y)) return -1;
+  int i = count++;
+  this->speed[i] = speed;
+  alive[i] = 0;
+  Respawn(i, x, y, direction);
+  return i;
+}
+
+// Keeps the snake's speed
+bool SnakePool::Respawn(int i, int x, int y, Snake::Direction direction) {
+  if (alive[i] || occupancy.IsOccupied(x, y)) return false;
+  head_x[i] = x << Snake::kFixedShift;
+  head_y[i] = y << Snake::kFixedShift;
+  this->direction[i] = static_cast<std::int32_t>(direction);
+  size[i] = 1;
+  alive[i] = 1;
+  growing[i] = 0;
+  body_first[i] = 0;
+  body_count[i] = 0;
+  occupancy.Occupy(x, y);
+  return true;
+}
+
+void SnakePool::SetDirection(int i, Snake::Direction direction) {
+  std::int32_t d = static_cast<std::int32_t>(direction);
+  // Up/down and left/right are adjacent pairs in Direction, so the opposite
+  // direction differs only in the lowest bit
+  if (d == (this->direction[i] ^ 1) && size[i] > 1) return;
+  this->direction[i] = d;
+}
+
+void SnakePool::Grow(int i) {
+  if (body_count[i] < max_length) growing[i] = 1;
+}
+
+void SnakePool::Update() {
+  ProposeMoves(0, count);
+  ReleaseTails();
+  ResolveHeads();
+}
+
+void SnakePool::Update(ThreadPool &threads) {
+  threads.ParallelFor(count, [this](int begin, int end) { ProposeMoves(begin, end); });
+  ReleaseTails();
+  ResolveHeads();
+}
+
+// Writes only entries [begin, end) of the per-snake arrays and never touches
+// the occupancy grid, so disjoint ranges can run at the same time
+void SnakePool::ProposeMoves(int begin, int end) {
+  HeadBatch batch{head_x.data(), head_y.data(), direction.data(), speed.data(), alive.data(),
+                  next_x.data(), next_y.data(), moved.data(),
+                  grid_width << Snake::kFixedShift, grid_height << Snake::kFixedShift};
+  HeadKernel::Advance(head_kernel, batch, begin, end);
+
+  for (int i = begin; i < end; ++i) {
+    released_cell[i] = -1;
+    if (!moved[i]) continue;
+    target_cell[i] = (next_y[i] >> Snake::kFixedShift) * grid_width + (next_x[i] >> Snake::kFixedShift);
+
+    // The old head cell becomes the neck; it stays occupied
+    std::int32_t prev_cell = (head_y[i] >> Snake::kFixedShift) * grid_width + (head_x[i] >> Snake::kFixedShift);
+    std::int32_t *ring = body_cells.data() + static_cast<std::size_t>(i) * max_length;
+    if (growing[i]) {
+      growing[i] = 0;
+      size[i]++;
+    } else {
+      if (body_count[i] == 0) {
+        released_cell[i] = prev_cell;
+        continue;
+      }
+      released_cell[i] = ring[body_first[i]];
+      body_first[i] = body_first[i] + 1 == max_length ? 0 : body_first[i] + 1;
+      body_count[i]--;
+    }
+    int slot = body_first[i] + body_count[i];
+    if (slot >= max_length) slot -= max_length;
+    ring[slot] = prev_cell;
+    body_count[i]++;
+  }
+
+  std::copy(next_x.begin() + begin, next_x.begin() + end, head_x.begin() + begin);
+  std::copy(next_y.begin() + begin, next_y.begin() + end, head_y.begin() + begin);
+}
+
+void SnakePool::ReleaseTails() {
+  for (int i = 0; i < count; ++i) {
+    if (released_cell[i] >= 0) occupancy.Vacate(released_cell[i]);
+  }
+}
+
+void SnakePool::ResolveHeads() {
+  for (int i = 0; i < count; ++i) {
+    if (!moved[i]) continue;
+    if (occupancy.IsOccupied(target_cell[i])) {
+      Kill(i);
+    } else {
+      occupancy.Occupy(target_cell[i]);
+    }
+  }
+}
+
+// The head has not claimed its new cell yet, so only the body is released
+void SnakePool::Kill(int i) {
+  alive[i] = 0;
+  std::int32_t const *ring = body_cells.data() + static_cast<std::size_t>(i) * max_length;
+  int slot = body_first[i];
+  for (int n = 0; n < body_count[i]; ++n) {
+    occupancy.Vacate(ring[slot]);
+    slot = slot + 1 == max_length ? 0 : slot + 1;
+  }
+  body_count[i] = 0;
+}
+
+// FNV-1a over the state that determines how the game continues
+std::uint64_t SnakePool::Checksum() const {
+  std::uint64_t hash = 14695981039346656037ull;
+  auto mix = [&hash](std::uint64_t value) {
+    hash ^= value;
+    hash *= 1099511628211ull;
+  };
+  for (int i = 0; i < count; ++i) {
+    mix(static_cast<std::uint32_t>(head_x[i]));
+    mix(static_cast<std::uint32_t>(head_y[i]));
+    mix(static_cast<std::uint32_t>(direction[i]));
+    mix(static_cast<std::uint32_t>(size[i]));
+    mix(alive[i]);
+    std::int32_t const *ring = body_cells.data() + static_cast<std::size_t>(i) * max_length;
+    int slot = body_first[i];
+    for (int n = 0; n < body_count[i]; ++n) {
+      mix(static_cast<std::uint32_t>(ring[slot]));
+      slot = slot + 1 == max_length ? 0 : slot + 1;
+    }
+  }
+  return hash;
+}
@@ -0,0 +1,110 @@
+#ifndef SNAKE_POOL_H
+#define SNAKE_POOL_H
+
+#include <cstdint>
+#include <vector>
+#include "SDL.h"
+#include "head_kernel.h"
+#include "occupancy_grid.h"
+#include "snake.h"
+#include "thread_pool.h"
+
+// Many snakes on one board, stored as structure of arrays: every per-snake
+// field lives in its own contiguous array, so each phase of an update is a
+// tight loop over a few arrays. All snakes share one occupancy grid.
+//
+// Movement uses the same fixed-point rules as Snake. One update runs in
+// three phases. First every live snake proposes its move: it advances its
+// head and, if the head entered a new cell, moves its neck into the body and
+// drops its tail unless growing. This phase touches only the snake's own
+// entries, so it can be split across threads. Then the dropped tails leave
+// the board, and finally, in index order, each moved head claims its new
+// cell. A head that finds the cell taken dies, and a dead snake leaves the
+// board at once. The last two phases always run on one thread, so the result
+// does not depend on how many threads shared the first.
+class SnakePool {
+ public:
+  // Constructor
+  // Allocates storage for max_snakes snakes of up to max_length body segments
+  // each (not counting the head); nothing is allocated after this.
+  SnakePool(int grid_width, int grid_height, int max_snakes, int max_length);
+
+  // Adds a snake of size 1 with its head in cell (x, y)
+  // Returns its index, or -1 if the pool is full or the cell is occupied
+  int Spawn(int x, int y, Snake::Direction direction, std::int32_t speed);
+
+  // Brings dead snake i back as a snake of size 1 with its head in cell (x, y)
+  // Returns false if the snake is alive or the cell is occupied
+  bool Respawn(int i, int x, int y, Snake::Direction direction);
+
+  // Sets the direction of snake i; like the keyboard controller, a reversal
+  // is ignored unless the snake is a single segment
+  void SetDirection(int i, Snake::Direction direction);
+
+  // Makes snake i grow by one on its next cell step; snakes at max_length stop growing
+  void Grow(int i);
+
+  // Advances every live snake by one update
+  void Update();
+  // Same as Update, with the proposal phase split across the pool's threads;
+  // the outcome is identical to Update
+  void Update(ThreadPool &threads);
+
+  // Public getter methods
+  int Count() const { return count; }
+  bool IsAlive(int i) const { return alive[i] != 0; }
+  int GetSize(int i) const { return size[i]; }
+  Snake::Direction GetDirection(int i) const { return static_cast<Snake::Direction>(direction[i]); }
+  SDL_Point GetHeadCell(int i) const {
+    return SDL_Point{head_x[i] >> Snake::kFixedShift, head_y[i] >> Snake::kFixedShift};
+  }
+  OccupancyGrid const &GetOccupancy() const { return occupancy; }
+
+  // Instruction set used to advance the heads, the widest supported by default
+  HeadKernel::Isa GetHeadKernel() const { return head_kernel; }
+  void SetHeadKernel(HeadKernel::Isa isa) { head_kernel = isa; }
+
+  // Hash of every snake's position, size and body, for comparing two runs
+  std::uint64_t Checksum() const;
+
+ private:
+  // Phase 1: moves the heads and bodies of snakes [begin, end) and records
+  // which moved to a new cell and which cell each left behind
+  void ProposeMoves(int begin, int end);
+  // Phase 2: removes the cells left behind from the board
+  void ReleaseTails();
+  // Phase 3: moved heads claim their cells in index order
+  void ResolveHeads();
+  // Removes a dead snake's cells from the board
+  void Kill(int i);
+
+  int grid_width;
+  int grid_height;
+  int max_snakes;
+  int max_length;
+  int count{0};
+  OccupancyGrid occupancy; // Heads and bodies of all live snakes
+  HeadKernel::Isa head_kernel{HeadKernel::Detect()};
+
+  // Per-snake state, one entry per snake
+  std::vector<std::int32_t> head_x; // Fixed point
+  std::vector<std::int32_t> head_y; // Fixed point
+  std::vector<std::int32_t> direction; // Snake::Direction as int
+  std::vector<std::int32_t> speed; // Fixed point
+  std::vector<std::int32_t> size;
+  std::vector<std::uint8_t> alive;
+  std::vector<std::uint8_t> growing;
+  std::vector<std::uint8_t> moved; // Head entered a new cell during this update
+  std::vector<std::int32_t> next_x; // Head after this update, written by the head kernel
+  std::vector<std::int32_t> next_y;
+  std::vector<std::int32_t> target_cell; // Cell index the head moved into
+  std::vector<std::int32_t> released_cell; // Cell index the snake left, -1 if none
+
+  // Bodies: snake i owns the ring of cell indices
+  // body_cells[i * max_length, (i + 1) * max_length)
+  std::vector<std::int32_t> body_cells;
+  std::vector<std::int32_t> body_first; // Ring position of the tail
+  std::vector<std::int32_t> body_count; // Number of body segments
+};
+
+#endif
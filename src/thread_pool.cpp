@@ -0,0 +1,67 @@
+#include "thread_pool.h"
+
+// Constructor
+// Worker i always runs chunk i + 1; chunk 0 belongs to the caller
+ThreadPool::ThreadPool(int threads) {
+  for (int chunk = 1; chunk < threads; ++chunk) {
+    workers.emplace_back(&ThreadPool::WorkerLoop, this, chunk);
+  }
+}
+
+// Destructor
+// Wakes the workers so they can see the stop flag, then joins them
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  job_ready.notify_all();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::ParallelFor(int count, std::function<void(int, int)> const &fn) {
+  if (workers.empty()) {
+    fn(0, count);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    job = &fn;
+    job_count = count;
+    pending = static_cast<int>(workers.size());
+    generation++;
+  }
+  job_ready.notify_all();
+
+  fn(ChunkBegin(0, count), ChunkBegin(1, count));
+
+  std::unique_lock<std::mutex> lock(mutex);
+  job_done.wait(lock, [this] { return pending == 0; });
+  job = nullptr;
+}
+
+void ThreadPool::WorkerLoop(int chunk) {
+  std::uint64_t seen_generation = 0;
+  while (true) {
+    std::function<void(int, int)> const *fn;
+    int count;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      job_ready.wait(lock, [&] { return stopping || generation != seen_generation; });
+      if (stopping) return;
+      seen_generation = generation;
+      fn = job;
+      count = job_count;
+    }
+
+    (*fn)(ChunkBegin(chunk, count), ChunkBegin(chunk + 1, count));
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      pending--;
+    }
+    job_done.notify_one();
+  }
+}
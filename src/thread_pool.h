@@ -0,0 +1,49 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that split index ranges between them. The
+// threads are started once and sleep between jobs, so a job costs one wake-up
+// per worker rather than a thread creation.
+class ThreadPool {
+ public:
+  // Constructor
+  // Starts threads - 1 workers; the thread calling ParallelFor is the last one
+  explicit ThreadPool(int threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Number of threads sharing each job, including the caller
+  int Size() const { return static_cast<int>(workers.size()) + 1; }
+
+  // Splits [0, count) into one contiguous chunk per thread, runs
+  // fn(begin, end) on every chunk and returns once all chunks are done
+  void ParallelFor(int count, std::function<void(int, int)> const &fn);
+
+ private:
+  void WorkerLoop(int chunk);
+  // Bounds of chunk out of Size() chunks of [0, count)
+  int ChunkBegin(int chunk, int count) const {
+    return static_cast<int>(static_cast<std::int64_t>(count) * chunk / Size());
+  }
+
+  std::vector<std::thread> workers;
+  std::mutex mutex; // Guards every field below
+  std::condition_variable job_ready;
+  std::condition_variable job_done;
+  std::function<void(int, int)> const *job{nullptr}; // Current job, valid while pending > 0
+  int job_count{0}; // Size of the current index range
+  std::uint64_t generation{0}; // Incremented for every job, wakes the workers
+  int pending{0}; // Workers still running the current job
+  bool stopping{false};
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef TIMER_QUEUE_H
+#define TIMER_QUEUE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Events keyed on simulation ticks, popped in tick order. Events due on the
+// same tick come out in the order they were scheduled, so the simulation stays
+// deterministic.
+template <typename T>
+class TimerQueue {
+ public:
+  // Schedules value to become due at the given tick
+  void Schedule(std::uint64_t tick, T const &value) {
+    heap.push_back(Timer{tick, next_sequence++, value});
+    std::push_heap(heap.begin(), heap.end(), Later);
+  }
+
+  // Removes the earliest event due at or before now and stores it in value
+  // Returns false if no event is due yet
+  bool PopDue(std::uint64_t now, T &value) {
+    if (heap.empty() || heap.front().tick > now) return false;
+    std::pop_heap(heap.begin(), heap.end(), Later);
+    value = heap.back().value;
+    heap.pop_back();
+    return true;
+  }
+
+  std::size_t Size() const { return heap.size(); }
+
+ private:
+  struct Timer {
+    std::uint64_t tick; // Tick at which the event is due
+    std::uint64_t sequence; // Scheduling order, breaks ties between equal ticks
+    T value;
+  };
+
+  // Heap order: the timer that is due first sits at the front
+  static bool Later(Timer const &a, Timer const &b) {
+    return a.tick != b.tick ? a.tick > b.tick : a.sequence > b.sequence;
+  }
+
+  std::vector<Timer> heap;
+  std::uint64_t next_sequence{0};
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "trace.h"
+
+#ifdef SNAKE_ENABLE_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+  char const *name;
+  std::int64_t start_ns;
+  std::int64_t duration_ns;
+};
+
+// Events of one thread. Only the owning thread writes; the count is
+// published with release so Write sees complete events.
+struct ThreadBuffer {
+  explicit ThreadBuffer(int thread_id) : thread_id(thread_id), events(Trace::kEventsPerThread) {}
+  int thread_id;
+  std::vector<TraceEvent> events;
+  std::atomic<std::size_t> count{0};
+};
+
+// Every buffer ever created; buffers live until the program ends, so a
+// thread that exits still has its events written
+struct Registry {
+  std::mutex mutex; // Guards buffers; taken once per thread, never per event
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+Registry &GetRegistry() {
+  static Registry registry;
+  return registry;
+}
+
+using Clock = std::chrono::steady_clock;
+Clock::time_point const kEpoch = Clock::now();
+
+std::int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - kEpoch).count();
+}
+
+ThreadBuffer &GetThreadBuffer() {
+  thread_local ThreadBuffer *buffer = nullptr;
+  if (buffer == nullptr) {
+    Registry &registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.buffers.push_back(std::make_unique<ThreadBuffer>(static_cast<int>(registry.buffers.size()) + 1));
+    buffer = registry.buffers.back().get();
+  }
+  return *buffer;
+}
+
+}  // namespace
+
+TraceScope::TraceScope(char const *name) : name(name), start_ns(NowNs()) {}
+
+TraceScope::~TraceScope() {
+  std::int64_t end_ns = NowNs();
+  ThreadBuffer &buffer = GetThreadBuffer();
+  std::size_t index = buffer.count.load(std::memory_order_relaxed);
+  buffer.events[index % Trace::kEventsPerThread] = TraceEvent{name, start_ns, end_ns - start_ns};
+  buffer.count.store(index + 1, std::memory_order_release);
+}
+
+bool Trace::Enabled() { return true; }
+
+// Complete ("X") events with timestamps in microseconds
+bool Trace::Write(std::string const &file_name) {
+  std::ofstream file(file_name);
+  if (!file) return false;
+  file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+  bool first = true;
+  Registry &registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (std::unique_ptr<ThreadBuffer> const &buffer : registry.buffers) {
+    std::size_t count = buffer->count.load(std::memory_order_acquire);
+    std::size_t begin = count > kEventsPerThread ? count - kEventsPerThread : 0;
+    for (std::size_t i = begin; i < count; ++i) {
+      TraceEvent const &event = buffer->events[i % kEventsPerThread];
+      file << (first ? "" : ",\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+           << buffer->thread_id << ",\"ts\":" << event.start_ns / 1000.0 << ",\"dur\":"
+           << event.duration_ns / 1000.0 << "}";
+      first = false;
+    }
+  }
+  file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return static_cast<bool>(file);
+}
+
+#else
+
+bool Trace::Enabled() { return false; }
+
+bool Trace::Write(std::string const &) { return false; }
+
+#endif
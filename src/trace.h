@@ -0,0 +1,62 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Scoped trace zones written as Chrome trace JSON (chrome://tracing or
+// ui.perfetto.dev). Tracing is compiled in only when SNAKE_ENABLE_TRACING is
+// defined (CMake option SNAKE_TRACING); otherwise TRACE_SCOPE expands to
+// nothing and the game pays no cost at all.
+//
+// Each thread records into its own fixed-size ring of events on first use,
+// without locks; the ring keeps the most recent events. Write must only be
+// called once the traced threads are idle.
+//
+//   void Game::Update() {
+//     TRACE_SCOPE("Game::Update");
+//     ...
+//   }
+
+class Trace {
+ public:
+  // Events kept per thread
+  static constexpr std::size_t kEventsPerThread = 1 << 16;
+
+  // True if tracing was compiled in
+  static bool Enabled();
+
+  // Writes every recorded event to file
+  // Returns false if tracing is compiled out or the file cannot be written
+  static bool Write(std::string const &file_name);
+};
+
+#ifdef SNAKE_ENABLE_TRACING
+
+// Records the time between its construction and destruction as one event
+class TraceScope {
+ public:
+  // name must outlive the program, as string literals do
+  explicit TraceScope(char const *name);
+  ~TraceScope();
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+ private:
+  char const *name;
+  std::int64_t start_ns;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <array>
+#include <atomic>
+
+// Hands the latest value from one producer thread to one consumer thread.
+// The producer fills Back() and publishes it; the consumer takes the most
+// recently published value into Front(). Neither side ever waits for the
+// other: values published faster than they are consumed are overwritten.
+template <typename T>
+class TripleBuffer {
+ public:
+  // Buffer the producer writes into; producer side only
+  T &Back() { return buffers[back]; }
+
+  // Makes Back() the latest value and hands the producer a free buffer to
+  // write next. The buffer handed back keeps whatever it held before.
+  void Publish() {
+    back = middle.exchange(back | kFresh, std::memory_order_acq_rel) & kIndexMask;
+  }
+
+  // Moves the latest published value into Front()
+  // Returns false, keeping Front() unchanged, if nothing new was published
+  bool Consume() {
+    if ((middle.load(std::memory_order_relaxed) & kFresh) == 0) return false;
+    front = middle.exchange(front, std::memory_order_acq_rel) & kIndexMask;
+    return true;
+  }
+
+  // Value taken by the last Consume; consumer side only
+  T const &Front() const { return buffers[front]; }
+
+ private:
+  static constexpr int kIndexMask = 3;
+  static constexpr int kFresh = 4; // Set on middle until the consumer takes it
+
+  std::array<T, 3> buffers;
+  int back{0}; // Owned by the producer
+  int front{1}; // Owned by the consumer
+  alignas(64) std::atomic<int> middle{2}; // Index of the buffer between the two, plus kFresh
+};
+
+#endif
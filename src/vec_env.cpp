@@ -0,0 +1,172 @@
+#include "vec_env.h"
+#include <algorithm>
+
+// Constructor
+// Every array is sized for num_envs games up front; each game starts with a
+// snake of size 1 at the centre of its board, as a new Snake does
+VecEnv::VecEnv(int num_envs, int grid_width, int grid_height, int threads)
+  : num_envs(num_envs),
+    grid_width(grid_width),
+    grid_height(grid_height),
+    threads(threads),
+    head_x(num_envs, (grid_width / 2) << Snake::kFixedShift),
+    head_y(num_envs, (grid_height / 2) << Snake::kFixedShift),
+    direction(num_envs, static_cast<std::int32_t>(Snake::Direction::kUp)),
+    speed(num_envs, Snake::kFixedOne),
+    alive(num_envs, 1),
+    next_x(num_envs),
+    next_y(num_envs),
+    moved(num_envs),
+    size(num_envs, 1),
+    growing(num_envs),
+    food(num_envs, -1),
+    drawn_food(num_envs, -1),
+    engines(num_envs),
+    scores(num_envs),
+    occupied(Base(num_envs)),
+    free_cells(Base(num_envs)),
+    free_slot(Base(num_envs)),
+    body_cells(Base(num_envs)),
+    free_count(num_envs),
+    body_first(num_envs),
+    body_count(num_envs),
+    observations(static_cast<std::size_t>(num_envs) * ObservationSize()),
+    rewards(num_envs),
+    dones(num_envs) {
+  for (int i = 0; i < num_envs; ++i) {
+    OccupancySlice board = Board(i);
+    board.Clear(grid_width * grid_height);
+    board.Occupy(HeadCell(i));
+  }
+}
+
+VecEnv::StepResult VecEnv::Reset(std::uint32_t const *seeds) {
+  threads.ParallelFor(num_envs, [this, seeds](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      ResetGame(i, seeds[i]);
+      rewards[i] = 0.0f;
+      dones[i] = 0;
+      Encode(i);
+    }
+  });
+  return Result();
+}
+
+VecEnv::StepResult VecEnv::Step(std::uint8_t const *actions) {
+  threads.ParallelFor(num_envs, [this, actions](int begin, int end) { StepRange(actions, begin, end); });
+  return Result();
+}
+
+// Each game touches only its own entries, so ranges can run on any thread.
+// A step is Snake::Update at one cell per step: the old head joins the body,
+// the tail leaves unless growing, and the head dies if its new cell is still
+// covered. Then, as in Game::Update, eating food grows the snake and places
+// new food.
+void VecEnv::StepRange(std::uint8_t const *actions, int begin, int end) {
+  for (int i = begin; i < end; ++i) {
+    int action = actions[i] & 3;
+    // Up/down and left/right are adjacent pairs in Direction
+    if (action != (direction[i] ^ 1) || size[i] == 1) direction[i] = action;
+  }
+  HeadBatch batch{head_x.data(), head_y.data(), direction.data(), speed.data(), alive.data(),
+                  next_x.data(), next_y.data(), moved.data(),
+                  grid_width << Snake::kFixedShift, grid_height << Snake::kFixedShift};
+  HeadKernel::Advance(head_kernel, batch, begin, end);
+
+  int cells = grid_width * grid_height;
+  for (int i = begin; i < end; ++i) {
+    OccupancySlice board = Board(i);
+    int previous = HeadCell(i);
+    head_x[i] = next_x[i];
+    head_y[i] = next_y[i];
+    int head = HeadCell(i);
+
+    // On a board one cell wide or high the head can stay in its cell
+    int tail = -1;
+    bool died = false;
+    if (moved[i]) {
+      std::int32_t *ring = body_cells.data() + Base(i);
+      ring[(body_first[i] + body_count[i]) % cells] = previous;
+      body_count[i]++;
+      if (!growing[i]) {
+        tail = ring[body_first[i]];
+        board.Vacate(tail);
+        body_first[i] = (body_first[i] + 1) % cells;
+        body_count[i]--;
+      } else {
+        growing[i] = 0;
+        size[i]++;
+      }
+      died = board.IsOccupied(head);
+      board.Occupy(head);
+    }
+
+    float reward = 0.0f;
+    bool done = died;
+    if (done) {
+      reward = kDeathReward;
+    } else if (head == food[i]) {
+      reward = kFoodReward;
+      scores[i]++;
+      growing[i] = 1;
+      // A snake that fills the board has won; the game ends with the food reward
+      done = !PlaceFood(i);
+    }
+    rewards[i] = reward;
+    dones[i] = done;
+    if (done) {
+      ResetGame(i, engines[i]());
+      Encode(i);
+    } else {
+      std::uint8_t *planes = Observation(i);
+      ObservationEncoder::WriteSnakeCell(planes, cells, previous, head, board.IsOccupied(previous));
+      if (tail >= 0) ObservationEncoder::WriteSnakeCell(planes, cells, tail, head, board.IsOccupied(tail));
+      ObservationEncoder::WriteSnakeCell(planes, cells, head, head, true);
+      ObservationEncoder::MoveMarker(planes, cells, ObservationEncoder::kFoodPlane, drawn_food[i], food[i]);
+    }
+  }
+}
+
+// Clears the whole board rather than releasing the snake's cells, so the
+// free cell list, and with it every food drawn, starts out as on a new board:
+// each game plays exactly as a new Game from the same seed would. Encode
+// rewrites every plane after a reset anyway.
+void VecEnv::ResetGame(int i, std::uint32_t seed) {
+  engines[i].seed(seed);
+  OccupancySlice board = Board(i);
+  board.Clear(grid_width * grid_height);
+  body_first[i] = 0;
+  body_count[i] = 0;
+
+  head_x[i] = (grid_width / 2) << Snake::kFixedShift;
+  head_y[i] = (grid_height / 2) << Snake::kFixedShift;
+  direction[i] = static_cast<std::int32_t>(Snake::Direction::kUp);
+  size[i] = 1;
+  growing[i] = 0;
+  board.Occupy(HeadCell(i));
+  scores[i] = 0;
+  PlaceFood(i);
+}
+
+bool VecEnv::PlaceFood(int i) {
+  food[i] = Board(i).RandomFree(engines[i]);
+  return food[i] >= 0;
+}
+
+void VecEnv::Encode(int i) {
+  std::uint8_t *planes = Observation(i);
+  std::fill(planes, planes + ObservationSize(), 0);
+  int cells = grid_width * grid_height;
+  int head = HeadCell(i);
+  std::int32_t const *ring = body_cells.data() + Base(i);
+  for (int k = 0; k < body_count[i]; ++k) {
+    ObservationEncoder::WriteSnakeCell(planes, cells, ring[(body_first[i] + k) % cells], head, true);
+  }
+  ObservationEncoder::WriteSnakeCell(planes, cells, head, head, true);
+  drawn_food[i] = -1;
+  ObservationEncoder::MoveMarker(planes, cells, ObservationEncoder::kFoodPlane, drawn_food[i], food[i]);
+}
+
+VecEnv::StepResult VecEnv::Result() const {
+  return StepResult{observations.data(), rewards.data(), dones.data()};
+}
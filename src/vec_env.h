@@ -0,0 +1,138 @@
+#ifndef VEC_ENV_H
+#define VEC_ENV_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "SDL.h"
+#include "head_kernel.h"
+#include "observation_encoder.h"
+#include "occupancy_grid.h"
+#include "snake.h"
+#include "thread_pool.h"
+
+// Many independent headless games stepped together, for training agents.
+// Every game is a snake and one food on its own board and plays like a new
+// Game from the same seed whose snake moves one cell per tick, with no
+// speed-up and no bonus food: the snake grows by one for each food and dies
+// when its head runs into its body. snake_bench checks games against Game
+// step by step.
+//
+// Games are stored as structure of arrays, like SnakePool: each per-game
+// field is one contiguous array, and each game's board, body ring and free
+// cell list are a slice of a flat buffer holding every game's, so nothing
+// is allocated per game and a step touches a few arrays instead of objects
+// scattered over the heap. The rules are not restated here: heads advance
+// with HeadKernel as in SnakePool, boards are kept and food is placed with
+// OccupancySlice as in OccupancyGrid, and observations are patched with the
+// cell and marker steps of ObservationEncoder.
+//
+// Observations are kept up to date incrementally from the cells each step
+// changed rather than rebuilt every step. Results live in flat buffers owned
+// by the VecEnv, one entry (or one observation) per game in game order. They
+// are overwritten by the next Reset or Step. A game that ends is reset at
+// once with a seed drawn from its own generator, so every game always has a
+// live snake and a run is reproducible from the seeds passed to Reset.
+class VecEnv {
+ public:
+  // Rewards for eating food and for dying
+  static constexpr float kFoodReward = 1.0f;
+  static constexpr float kDeathReward = -1.0f;
+
+  // Views of the result buffers
+  struct StepResult {
+    std::uint8_t const *observations; // num_envs * ObservationSize() bytes, see ObservationEncoder
+    float const *rewards; // num_envs entries
+    std::uint8_t const *dones; // num_envs entries, 1 if the game ended this step
+  };
+
+  // Constructor
+  // Allocates every game and buffer up front; steps are spread over the
+  // given number of threads
+  VecEnv(int num_envs, int grid_width, int grid_height, int threads);
+
+  // Starts game i from seeds[i]; seeds must hold NumEnvs() values
+  StepResult Reset(std::uint32_t const *seeds);
+
+  // Advances every game by one cell. actions[i] is a Snake::Direction as int
+  // for game i; as with the keyboard, reversing onto the body is ignored.
+  StepResult Step(std::uint8_t const *actions);
+
+  // Public getter methods
+  int NumEnvs() const { return num_envs; }
+  int ObservationSize() const { return ObservationEncoder::kPlaneCount * grid_width * grid_height; }
+  SDL_Point GetHeadCell(int i) const { return Cell(HeadCell(i)); }
+  Snake::Direction GetDirection(int i) const { return static_cast<Snake::Direction>(direction[i]); }
+  int GetSize(int i) const { return size[i]; }
+  // Checks if cell (x, y) of game i is covered by its snake
+  bool IsOccupied(int i, int x, int y) const { return occupied[Base(i) + y * grid_width + x] != 0; }
+  SDL_Point GetFood(int i) const { return Cell(food[i]); }
+  int GetScore(int i) const { return scores[i]; }
+
+ private:
+  // Steps games [begin, end)
+  void StepRange(std::uint8_t const *actions, int begin, int end);
+  // Starts game i from seed
+  void ResetGame(int i, std::uint32_t seed);
+  // Places food for game i; returns false if the snake fills the board
+  bool PlaceFood(int i);
+  // Rewrites every plane of game i's observation
+  void Encode(int i);
+  // Game i's slice of the board buffers
+  OccupancySlice Board(int i) {
+    std::size_t base = Base(i);
+    return OccupancySlice{occupied.data() + base, free_cells.data() + base, free_slot.data() + base,
+                          free_count.data() + i};
+  }
+  // Start of game i's slice of the per-cell buffers
+  std::size_t Base(int i) const { return static_cast<std::size_t>(i) * grid_width * grid_height; }
+  int HeadCell(int i) const {
+    return (head_y[i] >> Snake::kFixedShift) * grid_width + (head_x[i] >> Snake::kFixedShift);
+  }
+  SDL_Point Cell(int cell) const {
+    return cell >= 0 ? SDL_Point{cell % grid_width, cell / grid_width} : SDL_Point{-1, -1};
+  }
+  // Observation slot of game i
+  std::uint8_t *Observation(int i) {
+    return observations.data() + static_cast<std::size_t>(i) * ObservationSize();
+  }
+  StepResult Result() const;
+
+  int num_envs;
+  int grid_width;
+  int grid_height;
+  ThreadPool threads;
+  HeadKernel::Isa head_kernel{HeadKernel::Detect()};
+
+  // Per-game state, one entry per game
+  std::vector<std::int32_t> head_x; // Fixed point, as in Snake
+  std::vector<std::int32_t> head_y;
+  std::vector<std::int32_t> direction; // Snake::Direction as int
+  std::vector<std::int32_t> speed; // One cell per step in every game
+  std::vector<std::uint8_t> alive; // Always set: a game that ends restarts at once
+  std::vector<std::int32_t> next_x; // Head after this step, written by the head kernel
+  std::vector<std::int32_t> next_y;
+  std::vector<std::uint8_t> moved; // Head entered a new cell during this step
+  std::vector<std::int32_t> size;
+  std::vector<std::uint8_t> growing;
+  std::vector<std::int32_t> food; // Cell index of the food, -1 if none
+  std::vector<std::int32_t> drawn_food; // Cell index marked in the food plane, -1 if none
+  std::vector<std::mt19937> engines;
+  std::vector<int> scores;
+
+  // Boards: game i owns entries [Base(i), Base(i + 1)) of each buffer
+  std::vector<std::uint8_t> occupied; // Snake segments in each cell
+  std::vector<std::int32_t> free_cells; // Dense list of free cell indices
+  std::vector<std::int32_t> free_slot; // Position of each cell in free_cells, -1 if occupied
+  std::vector<std::int32_t> body_cells; // Ring of body cell indices from the tail
+  std::vector<std::int32_t> free_count; // Length of the free cell list, per game
+  std::vector<std::int32_t> body_first; // Ring position of the tail, per game
+  std::vector<std::int32_t> body_count; // Number of body segments, per game
+
+  // Result buffers
+  std::vector<std::uint8_t> observations;
+  std::vector<float> rewards;
+  std::vector<std::uint8_t> dones;
+};
+
+#endif